@@ -9,102 +9,613 @@
 #include <iomanip>
 #include <string>
 #include <set>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <unordered_set>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
 // Constants
 const double INF = numeric_limits<double>::max();
 const double EPSILON = 1e-9; // 0.000000001
+const double PI = 3.14159265358979323846;
+const double EARTH_RADIUS_KM = 6371.0;
 
 //------------------HELPER FUNCTIONS------------------------
-// Simple JSON parser helper functions
-string trim(const string& str) {
-    size_t first = str.find_first_not_of(" \t\r\n\"");
-    if (first == string::npos) return "";
-    size_t last = str.find_last_not_of(" \t\r\n\",");
-    return str.substr(first, (last - first + 1));
-}
+// Single-pass JSON tokenizer. The input is read through a fixed-size buffer,
+// so files of any size are parsed with bounded memory, and every value is
+// visited exactly once (no rescanning for keys).
+class JsonReader {
+private:
+    istream& in;
+    vector<char> buffer;
+    size_t pos;       // next unread byte in buffer
+    size_t end;       // valid bytes in buffer
+    size_t consumed;  // file offset of buffer[0]
+    bool error;
+    string scratch;   // reused by skipValue() for strings we don't keep
+
+    bool fill() {
+        if (pos < end) return true;
+        consumed += end;
+        pos = 0;
+        end = 0;
+        if (!in) return false;
+        in.read(buffer.data(), (streamsize)buffer.size());
+        end = (size_t)in.gcount();
+        return end > 0;
+    }
 
-string extractValue(const string& line, const string& key) {
-    size_t pos = line.find("\"" + key + "\"");
-    if (pos == string::npos) return "";
+    static bool isNumberChar(int c) {
+        return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+    }
 
-    pos = line.find(":", pos);
-    if (pos == string::npos) return "";
+    static void appendUtf8(string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += (char)cp;
+        }
+        else if (cp < 0x800) {
+            out += (char)(0xC0 | (cp >> 6));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000) {
+            out += (char)(0xE0 | (cp >> 12));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+        else {
+            out += (char)(0xF0 | (cp >> 18));
+            out += (char)(0x80 | ((cp >> 12) & 0x3F));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+    }
 
-    size_t start = line.find_first_not_of(" \t:", pos);
-    if (start == string::npos) return "";
+    bool readHex4(uint32_t& value) {
+        value = 0;
+        for (int i = 0; i < 4; i++) {
+            int c = get();
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else return fail();
+        }
+        return true;
+    }
 
-    size_t end;
-    if (line[start] == '"') {
-        start++;
-        end = line.find('"', start);
+    bool fail() {
+        error = true;
+        return false;
     }
-    else {
-        end = line.find_first_of(",}", start);
+
+public:
+    // startOffset is the file position the stream is at, used for offset()
+    explicit JsonReader(istream& input, size_t startOffset = 0, size_t bufferSize = 1 << 16)
+        : in(input), buffer(bufferSize), pos(0), end(0), consumed(startOffset), error(false) {
+        // Skip a UTF-8 byte order mark
+        if (startOffset == 0 && peek() == 0xEF) {
+            pos++;
+            if (get() != 0xBB || get() != 0xBF) fail();
+        }
+    }
+
+    int peek() { return fill() ? (unsigned char)buffer[pos] : EOF; }
+    int get() { return fill() ? (unsigned char)buffer[pos++] : EOF; }
+
+    // Byte offset of the next unread character
+    size_t offset() const { return consumed + pos; }
+    bool failed() const { return error; }
+
+    void skipWhitespace() {
+        while (fill()) {
+            char c = buffer[pos];
+            if (c != ' ' && c != '\t' && c != '\r' && c != '\n') return;
+            pos++;
+        }
+    }
+
+    // Consume c (after optional whitespace) if it is the next character
+    bool consume(char c) {
+        skipWhitespace();
+        if (peek() != c) return false;
+        pos++;
+        return true;
+    }
+
+    // Read a string value into out (reusing its capacity)
+    bool readString(string& out) {
+        out.clear();
+        if (!consume('"')) return fail();
+
+        while (fill()) {
+            // Copy the run of plain characters straight out of the buffer
+            size_t runStart = pos;
+            while (pos < end && buffer[pos] != '"' && buffer[pos] != '\\') pos++;
+            out.append(buffer.data() + runStart, pos - runStart);
+            if (pos == end) continue;
+
+            if (buffer[pos++] == '"') return true;
+
+            // Escape sequence
+            int c = get();
+            switch (c) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if (!readHex4(cp)) return false;
+                // Combine a UTF-16 surrogate pair
+                if (cp >= 0xD800 && cp <= 0xDBFF && peek() == '\\') {
+                    pos++;
+                    uint32_t low;
+                    if (get() != 'u' || !readHex4(low)) return fail();
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default:
+                return fail();
+            }
+        }
+        return fail(); // unterminated string
+    }
+
+    // Read a number without building a temporary string. Short decimals
+    // (the common case) are converted exactly from an integer mantissa;
+    // anything longer falls back to strtod on a small stack buffer.
+    bool readNumber(double& value) {
+        static const double powersOfTen[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        skipWhitespace();
+        char text[64];
+        size_t length = 0;
+        while (isNumberChar(peek())) {
+            if (length + 1 >= sizeof(text)) return fail();
+            text[length++] = (char)get();
+        }
+        text[length] = '\0';
+        if (length == 0) return fail();
+
+        // Fast path: [-]digits[.digits] with at most 15 significant digits
+        size_t i = 0;
+        bool negative = text[0] == '-';
+        if (negative) i++;
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int fractionDigits = 0;
+        bool inFraction = false;
+        bool simple = i < length;
+        for (; i < length && simple; i++) {
+            char c = text[i];
+            if (c >= '0' && c <= '9') {
+                mantissa = mantissa * 10 + (c - '0');
+                if (mantissa != 0) digits++;
+                if (inFraction) fractionDigits++;
+            }
+            else if (c == '.' && !inFraction) {
+                inFraction = true;
+            }
+            else {
+                simple = false;
+            }
+        }
+
+        if (simple && digits <= 15 && fractionDigits <= 22) {
+            value = (double)mantissa / powersOfTen[fractionDigits];
+            if (negative) value = -value;
+            return true;
+        }
+
+        char* parsedEnd = nullptr;
+        value = strtod(text, &parsedEnd);
+        if (parsedEnd != text + length) return fail();
+        return true;
+    }
+
+    // Skip over any value, including nested objects and arrays
+    bool skipValue() {
+        skipWhitespace();
+        int c = peek();
+        if (c == '"') return readString(scratch);
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            double ignored;
+            return readNumber(ignored);
+        }
+        if (c == '{' || c == '[') {
+            bool first = true;
+            if (c == '{') {
+                pos++;
+                while (nextKey(scratch, first)) {
+                    if (!skipValue()) return false;
+                }
+            }
+            else {
+                pos++;
+                while (nextElement(first)) {
+                    if (!skipValue()) return false;
+                }
+            }
+            return !error;
+        }
+        // true / false / null
+        while ((c = peek()) != EOF && isalpha(c)) pos++;
+        return true;
+    }
+
+    // Object iteration: after consuming '{', call nextKey() until it returns
+    // false. Each call leaves the reader positioned at the member's value.
+    bool nextKey(string& key, bool& first) {
+        skipWhitespace();
+        if (peek() == '}') {
+            pos++;
+            return false;
+        }
+        if (!first && !consume(',')) return fail();
+        first = false;
+        if (!readString(key) || !consume(':')) return fail();
+        return true;
+    }
+
+    // Array iteration: after consuming '[', call nextElement() until it
+    // returns false. Each call leaves the reader positioned at the element.
+    // End of file after a complete element also ends the array, since
+    // hand-edited data files are sometimes missing their closing brackets.
+    bool nextElement(bool& first) {
+        skipWhitespace();
+        int c = peek();
+        if (c == ']') {
+            pos++;
+            return false;
+        }
+        if (c == EOF) return false;
+        if (!first && !consume(',')) return fail();
+        first = false;
+        skipWhitespace();
+        return true;
     }
 
-    return trim(line.substr(start, end - start));
+    // True once only whitespace is left
+    bool atEnd() {
+        skipWhitespace();
+        return peek() == EOF;
+    }
+
+    // Error recovery for line-based input: drop the rest of the current line
+    void skipLine() {
+        int c;
+        while ((c = get()) != EOF && c != '\n') {}
+        error = false;
+    }
+
+    // Position the reader inside the array stored under a top-level key
+    bool findTopLevelArray(const string& name) {
+        if (!consume('{')) return fail();
+        bool first = true;
+        string key;
+        while (nextKey(key, first)) {
+            if (key == name && consume('[')) return true;
+            if (!skipValue()) return false;
+        }
+        return false;
+    }
+
+    // String member; other value types are skipped and leave out empty
+    bool readStringField(string& out) {
+        skipWhitespace();
+        if (peek() == '"') return readString(out);
+        out.clear();
+        return skipValue();
+    }
+
+    // Array-of-strings member; a lone string is read as a one-element list
+    // and non-string elements are skipped
+    bool readStringListField(vector<string>& out) {
+        out.clear();
+        skipWhitespace();
+        if (peek() == '"') {
+            out.emplace_back();
+            return readString(out.back());
+        }
+        if (!consume('[')) return skipValue();
+
+        bool first = true;
+        while (nextElement(first)) {
+            if (peek() == '"') {
+                out.emplace_back();
+                if (!readString(out.back())) return false;
+            }
+            else if (!skipValue()) {
+                return false;
+            }
+        }
+        return !error;
+    }
+
+    // Numeric member; numbers written as strings ("250") are accepted too
+    bool readNumberField(double& value) {
+        skipWhitespace();
+        int c = peek();
+        if (c == '-' || (c >= '0' && c <= '9')) return readNumber(value);
+        value = 0.0;
+        if (c == '"') {
+            if (!readString(scratch)) return false;
+            value = strtod(scratch.c_str(), nullptr);
+            return true;
+        }
+        return skipValue();
+    }
+};
+
+// Find the next array element boundary "}<ws>,<ws>{" at or after 'from'.
+// Returns the offset of the '{', or 'limit' if none is found before it.
+size_t findElementBoundary(istream& file, size_t from, size_t limit)
+{
+    vector<char> block(1 << 16);
+    int state = 0; // 0: looking for '}', 1: after '}', 2: after ','
+
+    file.clear();
+    file.seekg((streamoff)from);
+    size_t offset = from;
+    while (offset < limit && file) {
+        file.read(block.data(), (streamsize)block.size());
+        size_t got = (size_t)file.gcount();
+        if (got == 0) break;
+
+        for (size_t i = 0; i < got; i++) {
+            char c = block[i];
+            bool space = c == ' ' || c == '\t' || c == '\r' || c == '\n';
+            if (c == '}') state = 1;
+            else if (state == 1 && c == ',') state = 2;
+            else if (state == 2 && c == '{') return offset + i;
+            else if (!space) state = 0;
+        }
+        offset += got;
+    }
+    return limit;
 }
 
-// Helper: extract a quoted string value from a JSON object
-string extractStringValue(const string& json, const string& key, size_t objectStart)
+// Fixed pool of worker threads. parallelFor() hands out item indices through
+// an atomic counter and blocks until every item is done. The callback also
+// receives the index of the worker running it, so callers can keep
+// per-worker state (search workspaces, output buffers) without locking.
+class ThreadPool {
+private:
+    vector<thread> threads;
+    mutex lock;
+    condition_variable wake;
+    condition_variable done;
+    const function<void(size_t, size_t)>* job;
+    size_t jobSize;
+    atomic<size_t> nextItem;
+    size_t busyWorkers;
+    uint64_t jobGeneration;
+    bool stopping;
+
+    void workerLoop(size_t worker) {
+        uint64_t seenGeneration = 0;
+        while (true) {
+            const function<void(size_t, size_t)>* current;
+            size_t size;
+            {
+                unique_lock<mutex> guard(lock);
+                wake.wait(guard, [&]() { return stopping || jobGeneration != seenGeneration; });
+                if (stopping) return;
+                seenGeneration = jobGeneration;
+                current = job;
+                size = jobSize;
+            }
+
+            size_t item;
+            while ((item = nextItem++) < size) {
+                (*current)(worker, item);
+            }
+
+            lock_guard<mutex> guard(lock);
+            if (--busyWorkers == 0) done.notify_one();
+        }
+    }
+
+public:
+    explicit ThreadPool(size_t count)
+        : job(nullptr), jobSize(0), nextItem(0), busyWorkers(0), jobGeneration(0), stopping(false) {
+        for (size_t i = 0; i < max(count, size_t(1)); i++) {
+            threads.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread& worker : threads) {
+            worker.join();
+        }
+    }
+
+    size_t size() const { return threads.size(); }
+
+    // Run fn(worker, item) for every item in [0, count)
+    void parallelFor(size_t count, const function<void(size_t, size_t)>& fn) {
+        if (count == 0) return;
+        {
+            lock_guard<mutex> guard(lock);
+            job = &fn;
+            jobSize = count;
+            nextItem = 0;
+            busyWorkers = threads.size();
+            jobGeneration++;
+        }
+        wake.notify_all();
+
+        unique_lock<mutex> guard(lock);
+        done.wait(guard, [&]() { return busyWorkers == 0; });
+    }
+};
+
+// Great-circle distance in km (haversine). Angles are in radians; the
+// cosines of the latitudes are passed in because callers precompute them.
+double haversineKm(double lat1, double lon1, double cosLat1,
+    double lat2, double lon2, double cosLat2)
 {
-    // Find the key inside the current object
-    string searchKey = "\"" + key + "\"";
-    size_t keyPos = json.find(searchKey, objectStart);
-    if (keyPos == string::npos) return "";
+    double sinHalfLat = sin((lat2 - lat1) / 2);
+    double sinHalfLon = sin((lon2 - lon1) / 2);
+    double a = sinHalfLat * sinHalfLat + cosLat1 * cosLat2 * sinHalfLon * sinHalfLon;
+    return 2 * EARTH_RADIUS_KM * asin(min(1.0, sqrt(a)));
+}
 
-    // Move to the colon after the key
-    size_t colonPos = json.find(':', keyPos);
-    if (colonPos == string::npos) return "";
+// Minutes after midnight for an "HH:MM" clock time, -1 if it is not one
+int parseClockMinutes(const string& text) {
+    int hours = 0, minutes = 0;
+    char extra;
+    if (sscanf(text.c_str(), "%d:%d%c", &hours, &minutes, &extra) != 2) return -1;
+    if (hours < 0 || hours > 23 || minutes < 0 || minutes > 59) return -1;
+    return hours * 60 + minutes;
+}
+
+const int MINUTES_PER_DAY = 24 * 60;
+const int MINUTES_PER_WEEK = 7 * MINUTES_PER_DAY;
+const char* const WEEKDAY_NAMES[7] = { "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun" };
+
+// Weekdays a flight operates on as a bit mask (bit 0 = Monday). "Nx weekly"
+// flights are spread evenly over the week starting on Monday; "daily" and
+// anything unrecognised run every day.
+uint8_t parseOperatingDays(const string& frequency) {
+    int perWeek = 0;
+    char extra;
+    if (sscanf(frequency.c_str(), "%dx weekly%c", &perWeek, &extra) != 1) return 0x7F;
+    if (perWeek <= 0 || perWeek >= 7) return 0x7F;
+
+    uint8_t days = 0;
+    for (int i = 0; i < perWeek; i++) {
+        days |= (uint8_t)(1 << (i * 7 / perWeek));
+    }
+    return days;
+}
+
+// Minutes after Monday 00:00 for a "Mon 08:30" style time (day names are
+// matched case-insensitively), -1 if it is not one
+int parseWeekMinute(const string& text) {
+    size_t space = text.find(' ');
+    if (space == string::npos || space != 3) return -1;
+
+    string day = text.substr(0, 3);
+    transform(day.begin(), day.end(), day.begin(), ::tolower);
+    for (int d = 0; d < 7; d++) {
+        string name = WEEKDAY_NAMES[d];
+        transform(name.begin(), name.end(), name.begin(), ::tolower);
+        if (day != name) continue;
+
+        int clock = parseClockMinutes(text.substr(space + 1));
+        return clock < 0 ? -1 : d * MINUTES_PER_DAY + clock;
+    }
+    return -1;
+}
+
+// Offset from UTC in minutes for a timezone such as "PKT (UTC+5)" or
+// "IST (UTC+5:30)". Returns false (offset 0) if the text names no UTC offset.
+bool parseUtcOffset(const string& timezone, int& offset) {
+    offset = 0;
+    size_t at = timezone.find("UTC");
+    if (at == string::npos) return false;
 
-    // Skip whitespace and the opening quote
-    size_t valStart = json.find_first_not_of(" \t\r\n", colonPos + 1);
-    if (valStart == string::npos || json[valStart] != '"') return "";
+    const char* p = timezone.c_str() + at + 3;
+    if (*p != '+' && *p != '-') return true; // plain "UTC"
 
-    ++valStart;                                   // skip the opening "
-    size_t valEnd = json.find('"', valStart);     // closing quote
-    if (valEnd == string::npos) return "";
+    int sign = *p == '-' ? -1 : 1;
+    int hours = 0, minutes = 0;
+    if (sscanf(p + 1, "%d:%d", &hours, &minutes) < 1) return false;
+    if (hours < 0 || hours > 14 || minutes < 0 || minutes > 59) return false;
 
-    return json.substr(valStart, valEnd - valStart);
+    offset = sign * (hours * 60 + minutes);
+    return true;
 }
 
-// Helper: extract a numeric value from a JSON object
-double extractNumericValue(const string& json, const string& key, size_t objectStart)
-{
-    // Find the key inside the current object
-    string searchKey = "\"" + key + "\"";
-    size_t keyPos = json.find(searchKey, objectStart);
-    if (keyPos == string::npos) return 0.0;
+// Minute in [0, modulus) for a possibly negative time
+inline int wrapMinutes(int minute, int modulus) {
+    int wrapped = minute % modulus;
+    return wrapped < 0 ? wrapped + modulus : wrapped;
+}
 
-    // Move to the colon after the key
-    size_t colonPos = json.find(':', keyPos);
-    if (colonPos == string::npos) return 0.0;
+// "Tue 05:50" for minutes after Monday 00:00 (other weeks wrap onto this one)
+string formatWeekMinute(int minute) {
+    minute = wrapMinutes(minute, MINUTES_PER_WEEK);
+    int day = minute / MINUTES_PER_DAY;
+    int clock = minute % MINUTES_PER_DAY;
+    char text[16];
+    snprintf(text, sizeof(text), "%s %02d:%02d", WEEKDAY_NAMES[day], clock / 60, clock % 60);
+    return text;
+}
+// Seed of --synthetic networks
+const uint64_t SYNTHETIC_SEED = 20240601;
 
-    // Skip whitespace
-    size_t valStart = json.find_first_not_of(" \t\r\n", colonPos + 1);
-    if (valStart == string::npos) return 0.0;
+// Small deterministic generator (xorshift64*) for synthetic networks: the same
+// seed gives the same network on every platform and standard library
+struct SyntheticRandom {
+    uint64_t state;
 
-    // Find the end of the number (comma, } or ] )
-    size_t valEnd = json.find_first_of(",}]", valStart);
-    if (valEnd == string::npos) valEnd = json.size();
+    explicit SyntheticRandom(uint64_t seed) : state(seed ? seed : 1) {}
 
-    string numStr = json.substr(valStart, valEnd - valStart);
-    // Trim any trailing whitespace that might have slipped in
-    numStr = trim(numStr);
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ULL;
+    }
 
-    try {
-        return stod(numStr);
+    // Uniform in [0, n)
+    uint64_t below(uint64_t n) {
+        return next() % n;
     }
-    catch (...) {
-        return 0.0;
+
+    // Uniform in [low, high)
+    double between(double low, double high) {
+        return low + (high - low) * ((next() >> 11) * (1.0 / 9007199254740992.0));
     }
-}
+};
 //------------------EOF HELPER FUNCTIONS------------------------
 
 //--------------------DATA STRUCTURES---------------------------
 
+// Minimum connection time at airports that do not specify one
+const int DEFAULT_MIN_CONNECTION_MINUTES = 60;
+
 // City structure
 struct City {
     string code;
@@ -114,8 +625,9 @@ struct City {
     string timezone;
     double latitude;
     double longitude;
+    int minConnectionMinutes; // shortest allowed transfer between two flights
 
-    City() : latitude(0), longitude(0) {}
+    City() : latitude(0), longitude(0), minConnectionMinutes(DEFAULT_MIN_CONNECTION_MINUTES) {}
 };
 
 // Flight structure (Edge in graph)
@@ -129,14 +641,16 @@ struct Flight {
     string arrivalTime;
     string aircraft;
     int seatsAvailable;
+    string frequency; // "daily", "3x weekly", ...
 
     Flight() : duration(0), cost(0), seatsAvailable(0) {}
 
     Flight(string dest, string fNo, double dur, double c, string air,
-        string depTime = "", string arrTime = "", string craft = "", int seats = 0)
+        string depTime = "", string arrTime = "", string craft = "", int seats = 0,
+        string freq = "")
         : destination(dest), flightNo(fNo), duration(dur), cost(c),
         airline(air), departureTime(depTime), arrivalTime(arrTime),
-        aircraft(craft), seatsAvailable(seats) {
+        aircraft(craft), seatsAvailable(seats), frequency(freq) {
     }
 };
 
@@ -151,235 +665,2400 @@ struct Route {
     Route() : totalCost(0), totalDuration(0), stops(0) {}
 };
 
-// Priority queue element for Dijkstra's
-struct PQNode {
-    string city;
-    double cost;
-    double duration;
+// Route through the weekly timetable with the time each leg departs and
+// arrives, in minutes since the UTC epoch (Monday 00:00 UTC)
+struct Itinerary {
+    Route route;
+    vector<int> departures;
+    vector<int> arrivals;
+};
 
-    // Standard Dijkstra's uses cost only for ordering
-    bool operator>(const PQNode& other) const {
-        return cost > other.cost; // Min heap based on cost
+// City IDs are dense indices into the frozen graph's arrays
+typedef uint32_t CityId;
+const CityId INVALID_CITY = numeric_limits<CityId>::max();
+const uint32_t NO_EDGE = numeric_limits<uint32_t>::max();
+const int32_t NO_TIME = numeric_limits<int32_t>::max();
+
+// Airline IDs are dense indices into FlatGraph::airlineNames
+typedef uint16_t AirlineId;
+
+// Read-only memory mapping of a whole file (used for binary snapshots)
+class MappedFile {
+private:
+    const char* base;
+    size_t length;
+#ifdef _WIN32
+    HANDLE fileHandle;
+    HANDLE mappingHandle;
+#endif
+
+public:
+    MappedFile() : base(nullptr), length(0) {
+#ifdef _WIN32
+        fileHandle = INVALID_HANDLE_VALUE;
+        mappingHandle = NULL;
+#endif
     }
-};
 
-// Label structure for Multi-Objective Dijkstra (stores path properties)
-struct Label {
-    double cost;
-    double duration;
-    string parentCity;
-    Flight parentFlight;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (base) UnmapViewOfFile(base);
+        if (mappingHandle) CloseHandle(mappingHandle);
+        if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+#else
+        if (base) munmap((void*)base, length);
+#endif
+    }
 
-    // Default constructor for map initialization
-    Label() : cost(INF), duration(INF) {}
+    bool open(const string& filename) {
+#ifdef _WIN32
+        fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (fileHandle == INVALID_HANDLE_VALUE) return false;
 
-    // Check if *this* label dominates *other*.
-    // A dominates B if A is better in ALL criteria and strictly better in at least one.
-    bool dominates(const Label& other) const {
-        return cost <= other.cost && duration <= other.duration && (cost < other.cost || duration < other.duration);
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) return false;
+        length = (size_t)fileSize.QuadPart;
+
+        mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!mappingHandle) return false;
+
+        base = (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+        return base != nullptr;
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            return false;
+        }
+        length = (size_t)info.st_size;
+
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // the mapping stays valid after the descriptor is closed
+        if (mapped == MAP_FAILED) return false;
+
+        base = (const char*)mapped;
+        return true;
+#endif
     }
 
-    // Check if the current label is dominated by *other*.
-    bool isDominatedBy(const Label& other) const {
-        return other.dominates(*this);
+    const char* data() const { return base; }
+    size_t size() const { return length; }
+};
+
+// Binary snapshot layout. All sections are 8-byte aligned and addressed by
+// byte offsets from the start of the file, so the numeric CSR arrays can be
+// used directly from the mapping. Bump SNAPSHOT_VERSION on any layout change.
+const char SNAPSHOT_MAGIC[8] = { 'F', 'L', 'T', 'S', 'N', 'A', 'P', '\0' };
+const uint32_t SNAPSHOT_VERSION = 2;
+
+// Units of the cost and duration columns (snapshots written before the
+// field existed have zero there)
+const uint32_t WEIGHTS_DOLLARS_HOURS = 0;
+const uint32_t WEIGHTS_CENTS_MINUTES = 1;
+
+// String stored in the snapshot's string pool
+struct SnapshotString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;         // sizeof(SnapshotHeader) of the writer
+    uint32_t cityInfoCount;      // entries loaded from cities.json
+    uint32_t cityCount;          // interned airports in the graph
+    uint32_t flightCount;
+    uint32_t weightUnits;        // WEIGHTS_* units of the cost and duration columns
+    uint64_t cityInfoOffset;     // SnapshotCity[cityInfoCount]
+    uint64_t cityCodeOffset;     // SnapshotString[cityCount]
+    uint64_t firstEdgeOffset;    // uint32_t[cityCount + 1]
+    uint64_t edgeDestOffset;     // CityId[flightCount]
+    uint64_t edgeCostOffset;     // double[flightCount]
+    uint64_t edgeDurationOffset; // double[flightCount]
+    uint64_t flightInfoOffset;   // SnapshotFlight[flightCount]
+    uint64_t stringPoolOffset;
+    uint64_t stringPoolSize;
+    uint64_t fileSize;
+};
+
+struct SnapshotCity {
+    SnapshotString code;
+    SnapshotString name;
+    SnapshotString airportName;
+    SnapshotString country;
+    SnapshotString timezone;
+    double latitude;
+    double longitude;
+    int32_t minConnectionMinutes;
+    uint32_t reserved;
+};
+
+// Text metadata of one CSR edge
+struct SnapshotFlight {
+    SnapshotString flightNo;
+    SnapshotString destination;
+    SnapshotString airline;
+    SnapshotString departureTime;
+    SnapshotString arrivalTime;
+    SnapshotString aircraft;
+    SnapshotString frequency;
+    int32_t seatsAvailable;
+    uint32_t reserved;
+};
+
+// Append-only pool of strings in the snapshot layout. store() keeps one copy
+// of each distinct string; append() skips that lookup for strings that are
+// unique anyway (flight numbers).
+struct StringPool {
+    string data;
+    unordered_map<string, SnapshotString> pooled;
+
+    SnapshotString append(const string& str) {
+        SnapshotString ref = { (uint32_t)data.size(), (uint32_t)str.size() };
+        data += str;
+        return ref;
     }
 
-    // Equality check for duplicate labels
-    bool operator==(const Label& other) const {
-        return cost == other.cost && duration == other.duration;
+    SnapshotString store(const string& str) {
+        auto it = pooled.find(str);
+        if (it != pooled.end()) return it->second;
+
+        SnapshotString ref = append(str);
+        pooled[str] = ref;
+        return ref;
     }
 };
 
-// Priority Queue element for Multi-Objective search
-// The comparison can use a weighted sum (heuristic) or just one criterion.
-// We'll use a simple sum (Cost + Duration) as a heuristic to guide the search.
-struct PQElement {
-    string city;
-    double cost;
-    double duration;
-    double heuristicSum; // cost + duration
+// Text metadata of flight with its strings in pool (flight numbers pooled
+// like the rest only if poolNumbers is set)
+inline SnapshotFlight packFlight(const Flight& f, StringPool& pool, bool poolNumbers) {
+    SnapshotFlight record;
+    record.flightNo = poolNumbers ? pool.store(f.flightNo) : pool.append(f.flightNo);
+    record.destination = pool.store(f.destination);
+    record.airline = pool.store(f.airline);
+    record.departureTime = pool.store(f.departureTime);
+    record.arrivalTime = pool.store(f.arrivalTime);
+    record.aircraft = pool.store(f.aircraft);
+    record.frequency = pool.store(f.frequency);
+    record.seatsAvailable = f.seatsAvailable;
+    record.reserved = 0;
+    return record;
+}
+
+// Cold metadata of the flights of an in-memory graph, in the snapshot layout
+struct FlightMetadata {
+    vector<SnapshotFlight> flights;
+    string pool;
+};
+
+// Saved landmark tables: the header, then CityId[landmarkCount], then the
+// costFrom, costTo, durationFrom and durationTo tables as double[cityCount * landmarkCount].
+// graphChecksum ties the file to the graph it was computed on.
+const char LANDMARK_MAGIC[8] = { 'F', 'L', 'T', 'L', 'M', 'K', '\0', '\0' };
+const uint32_t LANDMARK_VERSION = 1;
+const size_t DEFAULT_LANDMARK_COUNT = 8;
+
+// Contraction hierarchies leave this fraction of the cities uncontracted;
+// the most important ones are searched as a core
+const double CORE_CITY_FRACTION = 0.05;
+
+struct LandmarkHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t landmarkCount;
+    uint32_t cityCount;
+    uint32_t flightCount;
+    uint64_t graphChecksum;
+};
+
+// Route matrix file: the header, then the origin codes followed by the
+// destination codes as NUL-terminated strings (codeBytes in total, padded to
+// 8 bytes), then the cost and the duration matrices as float[originCount *
+// destinationCount], one row per origin. Both describe the best route for the
+// objective: the cheapest route (and its duration) or the fastest route (and
+// its cost). Unreachable pairs hold +infinity.
+const char MATRIX_MAGIC[8] = { 'F', 'L', 'T', 'M', 'T', 'X', '\0', '\0' };
+const uint32_t MATRIX_VERSION = 1;
+
+struct MatrixHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t optimizeByCost;   // 1 = cheapest routes, 0 = fastest routes
+    uint32_t originCount;
+    uint32_t destinationCount;
+    uint64_t graphChecksum;
+    uint64_t codeBytes;
+    uint64_t costOffset;
+    uint64_t durationOffset;
+};
+
+// Read-only array that points either at a vector owned by the graph
+// or directly into a memory-mapped snapshot
+template <typename T>
+struct Column {
+    const T* data;
+    size_t count;
 
-    // Constructor for convenience
-    PQElement(string c, double co, double du)
-        : city(c), cost(co), duration(du), heuristicSum(co + du) {
+    Column() : data(nullptr), count(0) {}
+
+    void attach(const vector<T>& values) {
+        data = values.data();
+        count = values.size();
     }
 
-    // Min heap based on the heuristic sum
-    bool operator>(const PQElement& other) const {
-        return heuristicSum > other.heuristicSum;
+    void attach(const char* base, uint64_t offset, size_t n) {
+        data = (const T*)(base + offset);
+        count = n;
     }
+
+    const T& operator[](size_t i) const { return data[i]; }
+    size_t size() const { return count; }
 };
-// =========================================================
 
-//--------------------EOF DATA STRUCTURES---------------------------
+// Heap bytes reserved by a vector
+template <typename T>
+size_t vectorBytes(const vector<T>& v) {
+    return v.capacity() * sizeof(T);
+}
 
-// CLI Interface
-void displayMenu() {
-    cout << "\n--------------------------------------------------\n";
-    cout << "|      AIRLINE BOOKING SYSTEM                     |\n";
-    cout << "--------------------------------------------------\n";
-    cout << "1. Search Flights (Cheapest Route)\n";
-    cout << "2. Search Flights (Fastest Route)\n";
-    cout << "3. Search Flights (Minimum Stops)\n";
-    cout << "4. Search Flights (Pareto-Optimal Routes)  <-- NEW\n";
-    cout << "5. Compare All Three Optimal Options\n";
-    cout << "6. Display Network Stats\n";
-    cout << "7. List All Cities\n";
-    cout << "8. City Information\n";
-    cout << "9. Display ENTIRE Flight Graph\n";
-    cout << "0. Exit\n";
-    cout << string(48, '-') << "\n";
-    cout << "Enter choice: ";
+// ALT (A*, Landmarks, Triangle inequality) distance tables. Each table is
+// row-major by city: the values for city v and landmark i are at
+// [v * landmarks.size() + i], so one city's bounds are contiguous.
+struct LandmarkTables {
+    vector<CityId> landmarks;
+    vector<double> costFrom;     // cheapest cost landmark -> city
+    vector<double> costTo;       // cheapest cost city -> landmark
+    vector<double> durationFrom; // fastest duration landmark -> city
+    vector<double> durationTo;   // fastest duration city -> landmark
+
+    bool empty() const { return landmarks.empty(); }
+
+    // Triangle-inequality lower bound on the distance from v to t:
+    //   d(v, t) >= d(L, t) - d(L, v)   and   d(v, t) >= d(v, L) - d(t, L)
+    // Returns INF when v provably cannot reach t (a landmark reaches v but not t,
+    // or t reaches a landmark that v cannot).
+    double lowerBound(CityId v, CityId t, bool byCost) const {
+        const vector<double>& from = byCost ? costFrom : durationFrom;
+        const vector<double>& to = byCost ? costTo : durationTo;
+        size_t k = landmarks.size();
+        const double* fromV = &from[v * k];
+        const double* fromT = &from[t * k];
+        const double* toV = &to[v * k];
+        const double* toT = &to[t * k];
+
+        double best = 0;
+        for (size_t i = 0; i < k; i++) {
+            if (fromV[i] < INF) {
+                if (fromT[i] == INF) return INF;
+                best = max(best, fromT[i] - fromV[i]);
+            }
+            if (toT[i] < INF) {
+                if (toV[i] == INF) return INF;
+                best = max(best, toV[i] - toT[i]);
+            }
+        }
+        return best;
+    }
+};
+
+// Lexicographic (primary, secondary) weight comparison with the same
+// EPSILON tolerance that dijkstra() uses to detect equally good routes
+inline bool weightLess(double primaryA, double secondaryA, double primaryB, double secondaryB) {
+    if (primaryA < primaryB - EPSILON) return true;
+    return abs(primaryA - primaryB) < EPSILON && secondaryA < secondaryB - EPSILON;
 }
 
-void reconstructAllPaths(
-    const string& currentCity,
-    const string& source,
-    const unordered_map<string, vector<pair<string, Flight>>>& parentCandidates,
-    vector<Route>& finalRoutes,
-    Route currentRoute // Passed by value (copied)
-) {
-    // 1. Base Case: Reached the source city
-    if (currentCity == source) {
-        // Add the source city, finalize, and save the route.
-        currentRoute.cities.push_back(source);
-
-        // Reverse to get the chronological path (Source -> Destination)
-        reverse(currentRoute.cities.begin(), currentRoute.cities.end());
-        reverse(currentRoute.flights.begin(), currentRoute.flights.end());
-
-        // Recalculate totals (optional but good practice)
-        currentRoute.totalCost = 0;
-        currentRoute.totalDuration = 0;
-        for (const Flight& f : currentRoute.flights) {
-            currentRoute.totalCost += f.cost;
-            currentRoute.totalDuration += f.duration;
-        }
-        currentRoute.stops = currentRoute.flights.size(); // stops = number of flights - 1, but this is fixed later
-        currentRoute.stops = max(0, (int)currentRoute.flights.size() - 1);
-
-        finalRoutes.push_back(currentRoute);
-        return;
+inline bool weightTied(double primaryA, double secondaryA, double primaryB, double secondaryB) {
+    return abs(primaryA - primaryB) < EPSILON && abs(secondaryA - secondaryB) < EPSILON;
+}
+
+// Contraction hierarchy for one metric (cost or duration as primary weight,
+// the other as tiebreaker). Arcs [0, flightCount) are the flights themselves
+// (arc ID == edge ID); later arcs are shortcuts u -> w that skip arcMiddle.
+// Each pair of cities keeps at most one shortcut; equally good detours
+// through other contracted cities are listed in tiedMiddles instead, so a
+// query can still list every optimal route like dijkstra() does.
+struct ContractionHierarchy {
+    vector<uint32_t> rank; // CityId -> contraction order, higher = more important
+    uint32_t coreRank;     // cities ranked from here on were left uncontracted
+    vector<CityId> arcSource;
+    vector<CityId> arcTarget;
+    vector<double> arcPrimary;
+    vector<double> arcSecondary;
+    vector<CityId> arcMiddle; // INVALID_CITY for flights
+
+    // Other cities an arc can be unpacked through at the same weight:
+    // tiedMiddles[firstTiedMiddle[a] .. firstTiedMiddle[a + 1])
+    vector<uint32_t> firstTiedMiddle;
+    vector<CityId> tiedMiddles;
+
+    // Upward arcs u -> v (rank[v] > rank[u]) stored at u for the forward search,
+    // downward arcs u -> v (rank[u] > rank[v]) stored at v for the backward search.
+    // Arcs between two core cities are upward only: the forward search crosses
+    // the core and the backward search stops where it enters the core.
+    vector<uint32_t> firstUpArc;
+    vector<uint32_t> upArcs;
+    vector<uint32_t> firstDownArc;
+    vector<uint32_t> downArcs;
+
+    ContractionHierarchy() : coreRank(0) {}
+
+    bool empty() const { return rank.empty(); }
+    size_t coreSize() const { return rank.size() - coreRank; }
+    size_t shortcutCount() const { return arcMiddle.size() - count(arcMiddle.begin(), arcMiddle.end(), INVALID_CITY); }
+
+    uint32_t addArc(CityId source, CityId target, double primary, double secondary, CityId middle) {
+        arcSource.push_back(source);
+        arcTarget.push_back(target);
+        arcPrimary.push_back(primary);
+        arcSecondary.push_back(secondary);
+        arcMiddle.push_back(middle);
+        return (uint32_t)arcSource.size() - 1;
     }
 
-    if (parentCandidates.count(currentCity) == 0) {
-        return;
+    // Append to paths every flight sequence (edge IDs, in travel order) that
+    // the arc sequence stands for. A shortcut u -> w through middle m expands
+    // into each pair of downward arc u -> m and upward arc m -> w that adds
+    // up to its weight; a work list of partial paths replaces recursion.
+    void unpack(const vector<uint32_t>& arcs, vector<vector<uint32_t>>& paths) const {
+        struct Partial {
+            vector<uint32_t> edges;
+            vector<uint32_t> pending; // back() comes next in travel order
+        };
+        vector<Partial> work(1);
+        work[0].pending.assign(arcs.rbegin(), arcs.rend());
+        while (!work.empty()) {
+            Partial partial = move(work.back());
+            work.pop_back();
+            if (partial.pending.empty()) {
+                paths.push_back(move(partial.edges));
+                continue;
+            }
+            uint32_t a = partial.pending.back();
+            partial.pending.pop_back();
+
+            auto expand = [&](CityId m) {
+                for (uint32_t i = firstDownArc[m]; i < firstDownArc[m + 1]; i++) {
+                    uint32_t first = downArcs[i];
+                    if (arcSource[first] != arcSource[a]) continue;
+                    for (uint32_t j = firstUpArc[m]; j < firstUpArc[m + 1]; j++) {
+                        uint32_t second = upArcs[j];
+                        if (arcTarget[second] != arcTarget[a]) continue;
+                        if (!weightTied(arcPrimary[first] + arcPrimary[second], arcSecondary[first] + arcSecondary[second],
+                            arcPrimary[a], arcSecondary[a])) continue;
+                        work.push_back(partial);
+                        work.back().pending.push_back(second);
+                        work.back().pending.push_back(first);
+                    }
+                }
+            };
+            if (arcMiddle[a] != INVALID_CITY) expand(arcMiddle[a]);
+            for (uint32_t i = firstTiedMiddle[a]; i < firstTiedMiddle[a + 1]; i++) expand(tiedMiddles[i]);
+            if (arcMiddle[a] == INVALID_CITY) {
+                partial.edges.push_back(a);
+                work.push_back(move(partial));
+            }
+        }
+    }
+};
+
+// Arc arrays searched by a bidirectional query. The forward search leaves u
+// through forwardArcs[firstForward[u] .. firstForward[u + 1]) and the backward
+// search enters v through backwardArcs[firstBackward[v] .. firstBackward[v + 1]);
+// a null forwardArcs means the range holds the arc IDs themselves.
+struct BidirectionalArcs {
+    const uint32_t* firstForward;
+    const uint32_t* forwardArcs;
+    const uint32_t* firstBackward;
+    const uint32_t* backwardArcs;
+    const CityId* arcSource;
+    const CityId* arcTarget;
+    const double* arcPrimary;
+    const double* arcSecondary;
+    const ContractionHierarchy* hierarchy; // unpacks shortcuts, null when every arc is a flight
+};
+
+// One departure of a flight in the weekly timetable
+struct Connection {
+    int32_t departure; // minutes since the UTC epoch, within the first week
+    int32_t arrival;   // may run past the end of the week
+    CityId from;
+    CityId to;
+    uint32_t edge;
+};
+
+// Frozen compressed-sparse-row (CSR) form of the flight network.
+// The outbound flights of city u are the edges [firstEdge[u], firstEdge[u + 1]).
+// The search algorithms only touch the numeric columns; the text metadata of
+// each edge lives in a side table and is read through flight() when a route is built.
+// FlightGraph publishes each FlatGraph as an immutable version; changes are
+// made to a clone() that becomes the next version.
+struct FlatGraph {
+    uint64_t version;                      // publication number, see FlightGraph::publish()
+    vector<string> cityCodes;              // CityId -> IATA code
+    unordered_map<string, CityId> cityIds; // IATA code -> CityId
+    Column<uint32_t> firstEdge;            // size = cityCount() + 1
+    Column<CityId> edgeDest;
+    Column<double> edgeCost;     // dollars, or whole cents with integerWeights
+    Column<double> edgeDuration; // hours, or whole minutes with integerWeights
+
+    // Fixed-point weights: fares and durations are rounded to whole cents and
+    // minutes when they enter the graph. Totals of integer-valued doubles are
+    // exact (below 2^53), so equally good routes tie exactly and distinct
+    // totals differ by at least one unit.
+    bool integerWeights;
+
+    // Storage behind the columns for graphs built in memory
+    vector<uint32_t> firstEdgeData;
+    vector<CityId> edgeDestData;
+    vector<double> edgeCostData;
+    vector<double> edgeDurationData;
+
+    vector<int32_t> edgeSeats;
+
+    // Interned airline of each edge for airline filters; airlineIds is keyed
+    // by the upper-case name so filters match regardless of case
+    vector<AirlineId> edgeAirline;
+    vector<string> airlineNames;
+    unordered_map<string, AirlineId> airlineIds;
+
+    // Storage behind the columns for graphs mapped from a snapshot
+    shared_ptr<MappedFile> mapping;
+
+    // Cold side of the edges, only read to display routes: one SnapshotFlight
+    // per edge (same index as the edge arrays) with its strings in stringPool.
+    // Both point into the mapping or into flightMetadata. Fare and seat
+    // updates only change edgeCost and edgeSeats (flight() reads both from
+    // there), so versions that differ only in inventory share the metadata.
+    const SnapshotFlight* flightInfo;
+    const char* stringPool;
+    size_t stringPoolSize;
+    shared_ptr<const FlightMetadata> flightMetadata;
+
+    // Reverse adjacency: the flights arriving at city v are the edge IDs
+    // inEdges[firstInEdge[v] .. firstInEdge[v + 1]), and edgeSource maps an
+    // edge back to its origin
+    vector<uint32_t> firstInEdge;
+    vector<uint32_t> inEdges;
+    vector<CityId> edgeSource;
+
+    // Per-city time zone (minutes east of UTC) and minimum connection time,
+    // filled from the city records before buildSchedule()
+    vector<int16_t> cityUtcOffset;
+    vector<int32_t> minConnectionMinutes;
+
+    // Schedule of each edge in minutes since the UTC epoch (Monday 00:00 UTC)
+    // for its departure on the local Monday; departures on later operating
+    // days are whole days later. NO_TIME if the flight has no departure time.
+    vector<int32_t> edgeDepartureUtc;
+    vector<int32_t> edgeArrivalUtc;
+    vector<uint8_t> edgeOperatingDays;     // local weekday bit mask, see parseOperatingDays()
+
+    // Weekly timetable: every departure of every scheduled flight sorted by
+    // departure time. Shared by versions that differ only in fares or seats.
+    shared_ptr<const vector<Connection>> connections;
+
+    // Landmark bounds and contraction hierarchies, null until built (or
+    // loaded) and while stale after updates. Shared by the versions they
+    // are valid for, so clone() does not copy them.
+    shared_ptr<const LandmarkTables> landmarkTables;
+    shared_ptr<const ContractionHierarchy> costHierarchy;
+    shared_ptr<const ContractionHierarchy> durationHierarchy;
+
+    // Per-city coordinates (radians) for the A* great-circle bound
+    vector<double> cityLatitude;
+    vector<double> cityLongitude;
+    vector<double> cityCosLatitude;
+    double maxCruiseSpeed; // fastest observed km per duration unit over all flights, 0 = bound unavailable
+
+    FlatGraph() : version(0), integerWeights(false), flightInfo(nullptr), stringPool(nullptr), stringPoolSize(0),
+        maxCruiseSpeed(0) {}
+
+    FlatGraph& operator=(const FlatGraph&) = delete;
+
+    // Unpublished copy to build the next version from. Owned columns are
+    // pointed at the copy's vectors; mapped ones keep sharing the mapping.
+    shared_ptr<FlatGraph> clone() const {
+        shared_ptr<FlatGraph> copy(new FlatGraph(*this));
+        copy->version = 0;
+        if (!isMapped()) copy->attachOwnedColumns();
+        return copy;
     }
 
-    // 2. Recursive Step: Try every optimal parent candidate
-    for (const auto& candidate : parentCandidates.at(currentCity)) {
-        string parentCity = candidate.first;
-        Flight flight = candidate.second;
+private:
+    // Columns point into this object, so only clone() may copy it
+    FlatGraph(const FlatGraph&) = default;
 
-        // Create a new route object for the recursive call
-        Route nextRoute = currentRoute;
+public:
 
-        // Store the city and flight *segment* in reverse order (Destination <- Source)
-        nextRoute.cities.push_back(currentCity);
-        nextRoute.flights.push_back(flight);
+    size_t cityCount() const { return cityCodes.size(); }
+    size_t flightCount() const { return edgeDest.size(); }
+    bool isMapped() const { return mapping != nullptr; }
 
-        // Recurse to the parent city
-        reconstructAllPaths(parentCity, source, parentCandidates, finalRoutes, nextRoute);
+    CityId findCity(const string& code) const {
+        auto it = cityIds.find(code);
+        return it == cityIds.end() ? INVALID_CITY : it->second;
+    }
+
+    // Convert a fare (dollars) or a duration (hours) to the column units and back
+    double costWeight(double dollars) const { return integerWeights ? round(dollars * 100) : dollars; }
+    double durationWeight(double hours) const { return integerWeights ? round(hours * 60) : hours; }
+    double costValue(double weight) const { return integerWeights ? weight / 100 : weight; }
+    double durationValue(double weight) const { return integerWeights ? weight / 60 : weight; }
+
+    // Point the columns at the owned vectors
+    void attachOwnedColumns() {
+        firstEdge.attach(firstEdgeData);
+        edgeDest.attach(edgeDestData);
+        edgeCost.attach(edgeCostData);
+        edgeDuration.attach(edgeDurationData);
+        if (flightMetadata) {
+            flightInfo = flightMetadata->flights.data();
+            stringPool = flightMetadata->pool.data();
+            stringPoolSize = flightMetadata->pool.size();
+        }
     }
-}
 
+    // Convert the local clock times of every flight to UTC and expand the
+    // flights into the weekly timetable (needs cityUtcOffset and the reverse
+    // index). Departure and arrival times are local to their own airports; the
+    // flight duration only decides which day the arrival falls on, or gives the
+    // arrival when no arrival time is listed.
+    void buildSchedule() {
+        size_t m = flightCount();
+        edgeDepartureUtc.assign(m, NO_TIME);
+        edgeArrivalUtc.assign(m, NO_TIME);
+        edgeOperatingDays.resize(m);
+        vector<Connection> timetable;
+
+        for (uint32_t e = 0; e < m; e++) {
+            Flight f = flight(e);
+            edgeOperatingDays[e] = parseOperatingDays(f.frequency);
+
+            int departureClock = parseClockMinutes(f.departureTime);
+            if (departureClock < 0) continue; // unscheduled
+
+            CityId from = edgeSource[e];
+            CityId to = edgeDest[e];
+            int departure = departureClock - cityUtcOffset[from];
+            int travel = max(0, (int)lround(durationValue(edgeDuration[e]) * 60));
+
+            int arrivalClock = parseClockMinutes(f.arrivalTime);
+            if (arrivalClock >= 0) {
+                int elapsed = wrapMinutes(arrivalClock - cityUtcOffset[to] - departure, MINUTES_PER_DAY);
+                int extraDays = max(0, (int)lround((travel - elapsed) / (double)MINUTES_PER_DAY));
+                travel = elapsed + extraDays * MINUTES_PER_DAY;
+            }
 
-// Main Flight Graph class
-class FlightGraph {
-private:
-    unordered_map<string, vector<Flight>> adjList;
-    unordered_map<string, City> cities;
+            edgeDepartureUtc[e] = departure;
+            edgeArrivalUtc[e] = departure + travel;
+
+            for (int day = 0; day < 7; day++) {
+                if (!(edgeOperatingDays[e] & (1 << day))) continue;
+
+                Connection c;
+                c.departure = wrapMinutes(departure + day * MINUTES_PER_DAY, MINUTES_PER_WEEK);
+                c.arrival = c.departure + travel;
+                c.from = from;
+                c.to = to;
+                c.edge = e;
+                timetable.push_back(c);
+            }
+        }
+        stable_sort(timetable.begin(), timetable.end(),
+            [](const Connection& a, const Connection& b) { return a.departure < b.departure; });
+        connections = make_shared<const vector<Connection>>(move(timetable));
+    }
+
+    // Minutes from UTC week minute ready until edge e next departs, on any of
+    // its operating days (possibly next week); -1 if it has no departure time
+    int waitForDeparture(uint32_t e, int ready) const {
+        if (edgeDepartureUtc[e] == NO_TIME) return -1;
+        int wait = MINUTES_PER_WEEK;
+        for (int day = 0; day < 7; day++) {
+            if (!(edgeOperatingDays[e] & (1 << day))) continue;
+            wait = min(wait, wrapMinutes(edgeDepartureUtc[e] + day * MINUTES_PER_DAY - ready, MINUTES_PER_WEEK));
+        }
+        return wait;
+    }
+
+    // Build the reverse adjacency arrays from the forward CSR
+    void buildReverseIndex() {
+        size_t n = cityCount();
+        size_t m = flightCount();
+        firstInEdge.assign(n + 1, 0);
+        inEdges.resize(m);
+        edgeSource.resize(m);
+
+        for (CityId u = 0; u < n; u++) {
+            for (uint32_t e = firstEdge[u]; e < firstEdge[u + 1]; e++) {
+                edgeSource[e] = u;
+                firstInEdge[edgeDest[e] + 1]++;
+            }
+        }
+        for (size_t v = 0; v < n; v++) {
+            firstInEdge[v + 1] += firstInEdge[v];
+        }
+
+        vector<uint32_t> cursor(firstInEdge.begin(), firstInEdge.end() - 1);
+        for (uint32_t e = 0; e < m; e++) {
+            inEdges[cursor[edgeDest[e]]++] = e;
+        }
+    }
+
+    // Intern the airline of every edge into edgeAirline. Past the 65536th
+    // distinct name, airlines share the last ID (and so its filter bit).
+    void buildAirlineIndex() {
+        size_t m = flightCount();
+        edgeAirline.resize(m);
+        airlineNames.clear();
+        airlineIds.clear();
+
+        for (uint32_t e = 0; e < m; e++) {
+            string airline = poolString(flightInfo[e].airline);
+            string key = airline;
+            transform(key.begin(), key.end(), key.begin(), ::toupper);
+            auto it = airlineIds.find(key);
+            if (it == airlineIds.end()) {
+                if (airlineNames.size() <= numeric_limits<AirlineId>::max()) airlineNames.push_back(airline);
+                it = airlineIds.emplace(key, (AirlineId)(airlineNames.size() - 1)).first;
+            }
+            edgeAirline[e] = it->second;
+        }
+    }
+
+    // FNV-1a hash of the routing arrays, used to tie saved landmark tables to this graph
+    uint64_t checksum() const {
+        uint64_t hash = 1469598103934665603ULL;
+        auto mix = [&](const void* data, size_t bytes) {
+            const unsigned char* p = (const unsigned char*)data;
+            for (size_t i = 0; i < bytes; i++) {
+                hash = (hash ^ p[i]) * 1099511628211ULL;
+            }
+        };
+        for (const string& code : cityCodes) {
+            mix(code.data(), code.size());
+        }
+        mix(firstEdge.data, firstEdge.size() * sizeof(uint32_t));
+        mix(edgeDest.data, edgeDest.size() * sizeof(CityId));
+        mix(edgeCost.data, edgeCost.size() * sizeof(double));
+        mix(edgeDuration.data, edgeDuration.size() * sizeof(double));
+        return hash;
+    }
+
+    // Admissible lower bound on flying time (hours) from u to v: no flight in
+    // the network covers ground faster than maxCruiseSpeed, so no chain of
+    // flights can beat the great-circle distance at that speed
+    double travelTimeLowerBound(CityId u, CityId v) const {
+        if (maxCruiseSpeed <= 0) return 0;
+        return haversineKm(cityLatitude[u], cityLongitude[u], cityCosLatitude[u],
+            cityLatitude[v], cityLongitude[v], cityCosLatitude[v]) / maxCruiseSpeed;
+    }
+
+    string poolString(const SnapshotString& str) const {
+        return string(stringPool + str.offset, str.length);
+    }
+
+    string flightNumber(uint32_t e) const {
+        return poolString(flightInfo[e].flightNo);
+    }
+
+    // Full flight record of edge e, decoded from the string pool
+    Flight flight(uint32_t e) const {
+        const SnapshotFlight& info = flightInfo[e];
+        return Flight(poolString(info.destination), poolString(info.flightNo),
+            durationValue(edgeDuration[e]), costValue(edgeCost[e]), poolString(info.airline),
+            poolString(info.departureTime), poolString(info.arrivalTime),
+            poolString(info.aircraft), edgeSeats[e], poolString(info.frequency));
+    }
+};
+
+// Restrictions a customer puts on a search: a party size every flight must
+// have seats for, airlines to fly or avoid (names, any case) and airports to
+// connect through or avoid (codes). Empty lists restrict nothing, and the
+// source and destination never count as transit airports.
+struct RouteFilter {
+    int passengers;                  // 0 = any seat count
+    vector<string> airlines;         // fly only these
+    vector<string> excludedAirlines;
+    vector<string> transitAirports;  // connect only through these
+    vector<string> excludedTransits;
+
+    RouteFilter() : passengers(0) {}
+    explicit RouteFilter(int party) : passengers(party) {}
+
+    bool empty() const {
+        return passengers <= 0 && airlines.empty() && excludedAirlines.empty() &&
+            transitAirports.empty() && excludedTransits.empty();
+    }
+
+    // Canonical form for result cache keys, "" for no restrictions
+    string cacheKey() const {
+        if (empty()) return "";
+        string key = to_string(max(passengers, 0));
+        auto append = [&](char tag, const vector<string>& names) {
+            vector<string> sorted(names);
+            for (string& name : sorted) transform(name.begin(), name.end(), name.begin(), ::toupper);
+            sort(sorted.begin(), sorted.end());
+            for (const string& name : sorted) {
+                key += '\1';
+                key += tag;
+                key += name;
+            }
+        };
+        append('a', airlines);
+        append('A', excludedAirlines);
+        append('t', transitAirports);
+        append('T', excludedTransits);
+        return key;
+    }
+};
+
+// A RouteFilter resolved against one graph version into bit sets, so the
+// search loops test one airline bit (next to the seat count) per edge and
+// one transit bit per city they expand
+struct SearchFilter {
+    bool restrictsFlights;
+    bool restrictsTransits;
+    int32_t minSeats;
+    vector<uint64_t> airlineBits; // by AirlineId, set = may be flown
+    vector<uint64_t> transitBits; // by CityId, set = may be connected through
+
+    SearchFilter(const FlatGraph& g, const RouteFilter& filter) {
+        minSeats = filter.passengers > 0 ? filter.passengers : numeric_limits<int32_t>::min();
+        restrictsFlights = filter.passengers > 0 || !filter.airlines.empty() || !filter.excludedAirlines.empty();
+        restrictsTransits = !filter.transitAirports.empty() || !filter.excludedTransits.empty();
+
+        airlineBits.assign(g.airlineNames.size() / 64 + 1, filter.airlines.empty() ? ~0ULL : 0);
+        transitBits.assign(g.cityCount() / 64 + 1, filter.transitAirports.empty() ? ~0ULL : 0);
+        for (int pass = 0; pass < 2; pass++) {
+            for (string name : pass == 0 ? filter.airlines : filter.excludedAirlines) {
+                transform(name.begin(), name.end(), name.begin(), ::toupper);
+                auto it = g.airlineIds.find(name);
+                if (it != g.airlineIds.end()) assignBit(airlineBits, it->second, pass == 0);
+            }
+            for (string code : pass == 0 ? filter.transitAirports : filter.excludedTransits) {
+                transform(code.begin(), code.end(), code.begin(), ::toupper);
+                CityId u = g.findCity(code);
+                if (u != INVALID_CITY) assignBit(transitBits, u, pass == 0);
+            }
+        }
+    }
+
+    static void assignBit(vector<uint64_t>& bits, size_t i, bool value) {
+        if (value) bits[i >> 6] |= 1ULL << (i & 63);
+        else bits[i >> 6] &= ~(1ULL << (i & 63));
+    }
+
+    bool allowsFlight(const FlatGraph& g, uint32_t e) const {
+        AirlineId a = g.edgeAirline[e];
+        return g.edgeSeats[e] >= minSeats && ((airlineBits[a >> 6] >> (a & 63)) & 1);
+    }
+
+    bool allowsTransit(CityId u) const {
+        return (transitBits[u >> 6] >> (u & 63)) & 1;
+    }
+};
+
+// Priority queue element for Dijkstra's
+struct PQNode {
+    CityId city;
+    double cost;     // primary metric
+    double duration; // secondary metric
+    double priority; // primary metric plus the lower bound to the target (equal to cost without A*)
+
+    // Standard Dijkstra's uses cost only for ordering; A* adds the lower bound
+    bool operator>(const PQNode& other) const {
+        return priority > other.priority; // Min heap based on priority
+    }
+};
+
+// Queues of cities for the single-label searches (dijkstra(), the one-to-all
+// search and the spur searches), selected with FlightGraph::setSearchQueue().
+// Each holds a city at most once: push() queues it or lowers its key, pop()
+// takes out the city with the smallest key, and settled cities may be queued
+// again. The search keeps the totals of a city in its workspace, so an entry
+// is just the key and the city. reset() prepares a queue for a graph with
+// cityCount cities and drops whatever the last search left queued.
+enum QueueKind {
+    QUEUE_BINARY, // binary heap with lazy deletion
+    QUEUE_QUAD,   // indexed 4-ary heap with decrease-key
+    QUEUE_RADIX   // radix heap with decrease-key
+};
+
+const QueueKind DEFAULT_QUEUE = QUEUE_QUAD;
+
+const char* queueKindName(QueueKind kind) {
+    switch (kind) {
+    case QUEUE_BINARY: return "binary";
+    case QUEUE_QUAD: return "quad";
+    default: return "radix";
+    }
+}
+
+bool parseQueueKind(const string& name, QueueKind& kind) {
+    if (name == "binary") kind = QUEUE_BINARY;
+    else if (name == "quad") kind = QUEUE_QUAD;
+    else if (name == "radix") kind = QUEUE_RADIX;
+    else return false;
+    return true;
+}
+
+const uint32_t NOT_QUEUED = numeric_limits<uint32_t>::max();
+
+struct QueueEntry {
+    double key;
+    CityId city;
+
+    bool operator>(const QueueEntry& other) const {
+        return key > other.key;
+    }
+};
+
+// The previous queue of the searches: every improvement pushes a new entry
+// and the outdated ones are skipped when they come up
+class BinaryCityQueue {
+    vector<QueueEntry> heap;
+    vector<double> queuedKey; // key of the live entry of each city, INF if none
+
+    // Drop outdated entries off the top
+    void skipStale() {
+        while (!heap.empty() && heap.front().key != queuedKey[heap.front().city]) {
+            pop_heap(heap.begin(), heap.end(), greater<QueueEntry>());
+            heap.pop_back();
+        }
+    }
+
+public:
+    void reset(size_t cityCount) {
+        for (const QueueEntry& entry : heap) queuedKey[entry.city] = INF;
+        heap.clear();
+        if (queuedKey.size() < cityCount) queuedKey.resize(cityCount, INF);
+    }
+
+    bool empty() {
+        skipStale();
+        return heap.empty();
+    }
+
+    // Smallest key (queue not empty)
+    double minKey() {
+        skipStale();
+        return heap.front().key;
+    }
+
+    void push(CityId u, double key) {
+        if (key >= queuedKey[u]) return;
+        queuedKey[u] = key;
+        heap.push_back({ key, u });
+        push_heap(heap.begin(), heap.end(), greater<QueueEntry>());
+    }
+
+    CityId pop() {
+        skipStale();
+        CityId u = heap.front().city;
+        pop_heap(heap.begin(), heap.end(), greater<QueueEntry>());
+        heap.pop_back();
+        queuedKey[u] = INF;
+        return u;
+    }
+};
+
+// Indexed 4-ary heap: position[] locates every queued city, so a better key
+// moves its entry up instead of adding one. Half as deep as a binary heap,
+// and the four children of an entry sit next to each other in memory.
+class QuadHeap {
+    vector<QueueEntry> heap;
+    vector<uint32_t> position; // index in heap, NOT_QUEUED if absent
+
+    void place(size_t i, const QueueEntry& entry) {
+        heap[i] = entry;
+        position[entry.city] = (uint32_t)i;
+    }
+
+    void siftUp(size_t i, QueueEntry entry) {
+        while (i > 0) {
+            size_t parent = (i - 1) / 4;
+            if (!(entry.key < heap[parent].key)) break;
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, entry);
+    }
+
+    void siftDown(size_t i, QueueEntry entry) {
+        size_t n = heap.size();
+        while (true) {
+            size_t first = 4 * i + 1;
+            if (first >= n) break;
+            size_t last = min(first + 4, n);
+            size_t best = first;
+            for (size_t c = first + 1; c < last; c++) {
+                if (heap[c].key < heap[best].key) best = c;
+            }
+            if (!(heap[best].key < entry.key)) break;
+            place(i, heap[best]);
+            i = best;
+        }
+        place(i, entry);
+    }
+
+public:
+    void reset(size_t cityCount) {
+        for (const QueueEntry& entry : heap) position[entry.city] = NOT_QUEUED;
+        heap.clear();
+        if (position.size() < cityCount) position.resize(cityCount, NOT_QUEUED);
+    }
+
+    bool empty() const { return heap.empty(); }
+
+    double minKey() const { return heap.front().key; }
+
+    void push(CityId u, double key) {
+        uint32_t at = position[u];
+        if (at == NOT_QUEUED) {
+            heap.push_back({ key, u });
+            siftUp(heap.size() - 1, { key, u });
+        }
+        else if (key < heap[at].key) {
+            siftUp(at, { key, u });
+        }
+    }
+
+    CityId pop() {
+        CityId u = heap.front().city;
+        position[u] = NOT_QUEUED;
+        QueueEntry last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) siftDown(0, last);
+        return u;
+    }
+};
+
+// Index of the highest set bit of x (x > 0)
+inline int highestBit(uint64_t x) {
+    int bit = 0;
+    if (x >> 32) { x >>= 32; bit += 32; }
+    if (x >> 16) { x >>= 16; bit += 16; }
+    if (x >> 8) { x >>= 8; bit += 8; }
+    if (x >> 4) { x >>= 4; bit += 4; }
+    if (x >> 2) { x >>= 2; bit += 2; }
+    if (x >> 1) bit += 1;
+    return bit;
+}
+
+// Radix heap for searches whose keys never drop below the last key taken
+// out, as in Dijkstra's and A* with a consistent bound. Keys are ordered by
+// the bit patterns of non-negative doubles, which sort like the values, so
+// whole cents and minutes as well as fractional totals are compared exactly.
+// Bucket b > 0 holds the keys whose highest bit differing from the last key
+// taken out is b - 1; pop() only ever scans and redistributes the first
+// non-empty bucket. Callers must never push a key below the last one popped;
+// one that rounding put just below it (within EPSILON) is queued at the last
+// key.
+class RadixHeap {
+    struct Slot {
+        uint32_t bucket; // NOT_QUEUED if absent
+        uint32_t index;
+    };
+    struct Entry {
+        uint64_t key;
+        CityId city;
+    };
+
+    static const int BUCKETS = 65;
+    vector<Entry> buckets[BUCKETS];
+    vector<Slot> slot;
+    uint64_t last;
+    size_t count;
+
+    static uint64_t keyBits(double key) {
+        if (!(key > 0)) return 0; // also maps -0.0 to +0.0
+        uint64_t bits;
+        memcpy(&bits, &key, sizeof(bits));
+        return bits;
+    }
+
+    static double keyValue(uint64_t bits) {
+        double key;
+        memcpy(&key, &bits, sizeof(key));
+        return key;
+    }
+
+    uint32_t bucketOf(uint64_t key) const {
+        return key == last ? 0 : highestBit(key ^ last) + 1;
+    }
+
+    void insert(const Entry& entry) {
+        uint32_t b = bucketOf(entry.key);
+        slot[entry.city] = { b, (uint32_t)buckets[b].size() };
+        buckets[b].push_back(entry);
+    }
+
+    void remove(const Slot& at) {
+        vector<Entry>& bucket = buckets[at.bucket];
+        bucket[at.index] = bucket.back();
+        slot[bucket[at.index].city].index = at.index;
+        bucket.pop_back();
+    }
+
+    // Make the last key the smallest one queued, so bucket 0 holds the minimum
+    void refill() {
+        if (!buckets[0].empty()) return;
+        int b = 1;
+        while (buckets[b].empty()) b++;
+
+        vector<Entry>& bucket = buckets[b];
+        uint64_t smallest = bucket[0].key;
+        for (const Entry& entry : bucket) smallest = min(smallest, entry.key);
+        last = smallest;
+        for (const Entry& entry : bucket) insert(entry); // all land in lower buckets
+        bucket.clear();
+    }
+
+public:
+    RadixHeap() : last(0), count(0) {}
+
+    void reset(size_t cityCount) {
+        for (vector<Entry>& bucket : buckets) {
+            for (const Entry& entry : bucket) slot[entry.city].bucket = NOT_QUEUED;
+            bucket.clear();
+        }
+        if (slot.size() < cityCount) slot.resize(cityCount, { NOT_QUEUED, 0 });
+        last = 0;
+        count = 0;
+    }
+
+    bool empty() const { return count == 0; }
+
+    double minKey() {
+        refill();
+        return keyValue(last);
+    }
+
+    void push(CityId u, double key) {
+        assert(keyBits(key) >= last || keyValue(last) - key <= EPSILON);
+        uint64_t bits = max(keyBits(key), last);
+        Slot at = slot[u];
+        if (at.bucket == NOT_QUEUED) {
+            count++;
+        }
+        else {
+            if (bits >= buckets[at.bucket][at.index].key) return;
+            remove(at);
+        }
+        insert({ bits, u });
+    }
+
+    CityId pop() {
+        refill();
+        CityId u = buckets[0].back().city;
+        buckets[0].pop_back();
+        slot[u].bucket = NOT_QUEUED;
+        count--;
+        return u;
+    }
+};
+
+// Label structure for Multi-Objective Dijkstra (stores path properties).
+// Labels live in a pool and refer to the label they extend by index.
+const uint32_t NO_LABEL = numeric_limits<uint32_t>::max();
+
+struct Label {
+    double cost;
+    double duration;
+    CityId city;
+    uint32_t parent;     // pool index of the label this one extends (NO_LABEL at the source)
+    uint32_t parentEdge; // CSR edge used to reach this label (NO_EDGE at the source)
+    bool dominated;      // removed from its city's set; queue entries for it are stale
+
+    Label(double c, double d, CityId u, uint32_t p, uint32_t e)
+        : cost(c), duration(d), city(u), parent(p), parentEdge(e), dominated(false) {
+    }
+
+    // Check if *this* label dominates *other*.
+    // A dominates B if A is better in ALL criteria and strictly better in at least one.
+    bool dominates(const Label& other) const {
+        return cost <= other.cost && duration <= other.duration && (cost < other.cost || duration < other.duration);
+    }
+};
+
+// Priority queue element for the label-setting search: exactly one label
+struct PQElement {
+    uint32_t label;
+    double cost;
+    double duration;
+
+    PQElement(uint32_t l, double co, double du) : label(l), cost(co), duration(du) {}
+
+    // Lexicographic (cost, duration) order: a label can only be dominated by
+    // one that comes out of the queue before it, so popped labels are final
+    bool operator>(const PQElement& other) const {
+        if (cost != other.cost) return cost > other.cost;
+        return duration > other.duration;
+    }
+};
+
+// Alternative routes returned by default, and the time the K-shortest-paths
+// search may take before it returns the routes found so far
+const size_t DEFAULT_ALTERNATIVES = 20;
+const int DEFAULT_ALTERNATIVES_BUDGET_MS = 100;
+
+const uint32_t NO_NODE = numeric_limits<uint32_t>::max();
+
+// Node of the prefix tree of the K-shortest-paths search. Every route the
+// search generates is the path from the root (the source) down to a node, so
+// routes with a common prefix share its nodes instead of copying them.
+struct PathNode {
+    CityId city;
+    uint32_t edge;        // CSR edge into this node (NO_EDGE at the root)
+    uint32_t parent;      // NO_NODE at the root
+    uint32_t firstChild;  // children form a singly linked list
+    uint32_t nextSibling;
+    uint32_t depth;       // flights from the source
+    double cost;          // totals of the prefix
+    double duration;
+    bool accepted;        // lies on a route already returned
+    bool queued;          // ends a route waiting in the candidate list
+};
+
+// Routes found by one query as edge IDs, stored back to back: path i is
+// edges[first[i] .. first[i + 1]) in travel order. Searches fill it from their
+// parent links and build Route objects from it only once they return.
+struct PathArena {
+    vector<uint32_t> edges;
+    vector<uint32_t> first;
+
+    PathArena() : first(1, 0) {}
+
+    void clear() {
+        edges.clear();
+        first.assign(1, 0);
+    }
+
+    size_t size() const { return first.size() - 1; }
+
+    const uint32_t* begin(size_t i) const { return edges.data() + first[i]; }
+    const uint32_t* end(size_t i) const { return edges.data() + first[i + 1]; }
+
+    // Close the path made of the edges appended since the last one
+    void close() { first.push_back((uint32_t)edges.size()); }
+
+    // Add the path ending with label l of a label pool, following its parent
+    // links; the path is written back to front so it needs no reversing
+    template <typename L>
+    void addLabelPath(const vector<L>& pool, uint32_t l, uint32_t noLabel) {
+        size_t length = 0;
+        for (uint32_t at = l; pool[at].parent != noLabel; at = pool[at].parent) length++;
+        edges.resize(edges.size() + length);
+        size_t slot = edges.size();
+        for (uint32_t at = l; pool[at].parent != noLabel; at = pool[at].parent) {
+            edges[--slot] = pool[at].parentEdge;
+        }
+        close();
+    }
+};
+
+// Pareto set of one city: label indices sorted by increasing cost, which on a
+// two-criteria front means strictly decreasing duration
+
+// True if some label in front is at least as good as (cost, duration) in both criteria
+inline bool paretoCovered(const vector<Label>& pool, const vector<uint32_t>& front, double cost, double duration) {
+    // The last label with cost <= cost has the smallest duration among them
+    auto it = upper_bound(front.begin(), front.end(), cost,
+        [&](double c, uint32_t l) { return c < pool[l].cost; });
+    return it != front.begin() && pool[*(it - 1)].duration <= duration;
+}
+
+// Insert label l (not covered by front) and drop the labels it dominates
+inline void paretoInsert(vector<Label>& pool, vector<uint32_t>& front, uint32_t l) {
+    const Label& label = pool[l];
+    auto it = upper_bound(front.begin(), front.end(), label.cost,
+        [&](double c, uint32_t other) { return c < pool[other].cost; });
+
+    // Dominated labels follow it: an equal cost one just before, then those with no better duration
+    auto first = it;
+    if (first != front.begin() && pool[*(first - 1)].cost == label.cost) --first;
+    auto last = it;
+    while (last != front.end() && pool[*last].duration >= label.duration) ++last;
+    for (auto d = first; d != last; ++d) pool[*d].dominated = true;
+
+    if (first != last) {
+        *first = l;
+        front.erase(first + 1, last);
+    }
+    else {
+        front.insert(first, l);
+    }
+}
+
+// Criteria of the generalized Pareto search (bit flags). Labels always carry
+// all four values; criteria that are switched off stay 0 and never decide
+// dominance.
+const unsigned CRITERION_COST = 1;
+const unsigned CRITERION_DURATION = 2;
+const unsigned CRITERION_HOPS = 4;
+const unsigned CRITERION_LAYOVER = 8; // ground time between connecting flights
+const int MAX_CRITERIA = 4;
+
+struct CriteriaLabel {
+    double value[MAX_CRITERIA]; // cost, duration, hops, layover (duration units)
+    CityId city;
+    uint32_t parent;     // pool index of the label this one extends (NO_LABEL at the source)
+    uint32_t parentEdge; // CSR edge used to reach this label (NO_EDGE at the source)
+    int32_t arrival;     // UTC minute of the week it lands, NO_TIME if not known
+    bool dominated;
+};
+
+struct CriteriaQueueEntry {
+    uint32_t label;
+    double value[MAX_CRITERIA];
+
+    // Lexicographic order, so a label is always popped after any label dominating it
+    bool operator>(const CriteriaQueueEntry& other) const {
+        for (int i = 0; i < MAX_CRITERIA; i++) {
+            if (value[i] != other.value[i]) return value[i] > other.value[i];
+        }
+        return false;
+    }
+};
+
+// Non-dominated labels of one city with the same hop count (and, when
+// layovers count, the same arrival minute of the week: labels that land at
+// different times lead to different layovers, so they are not comparable). A label can
+// only be dominated from buckets with no more hops, which skips most of the
+// front. Values are stored column-wise so the dominance scans vectorize.
+struct CriteriaBucket {
+    int hops;
+    int arrival;
+    vector<double> cost;
+    vector<double> duration;
+    vector<double> layover;
+    vector<uint32_t> label;
+
+    void reset(int h, int a) {
+        hops = h;
+        arrival = a;
+        cost.clear();
+        duration.clear();
+        layover.clear();
+        label.clear();
+    }
+
+    // True if some label here is at least as good as (c, d, l)
+    bool covers(double c, double d, double l) const {
+        const size_t BLOCK = 64;
+        size_t n = label.size();
+        for (size_t begin = 0; begin < n; begin += BLOCK) {
+            size_t end = min(n, begin + BLOCK);
+            bool hit = false;
+            for (size_t i = begin; i < end; i++) {
+                hit |= (cost[i] <= c) & (duration[i] <= d) & (layover[i] <= l);
+            }
+            if (hit) return true;
+        }
+        return false;
+    }
+
+    // Drop (and flag in pool) every label no better than (c, d, l)
+    void removeCovered(vector<CriteriaLabel>& pool, double c, double d, double l) {
+        for (size_t i = 0; i < label.size();) {
+            if (cost[i] >= c && duration[i] >= d && layover[i] >= l) {
+                pool[label[i]].dominated = true;
+                cost[i] = cost.back();
+                duration[i] = duration.back();
+                layover[i] = layover.back();
+                label[i] = label.back();
+                cost.pop_back();
+                duration.pop_back();
+                layover.pop_back();
+                label.pop_back();
+            }
+            else {
+                i++;
+            }
+        }
+    }
+
+    void add(const CriteriaLabel& l, uint32_t index) {
+        cost.push_back(l.value[0]);
+        duration.push_back(l.value[1]);
+        layover.push_back(l.value[3]);
+        label.push_back(index);
+    }
+};
+
+// Per-thread scratch memory for the searches. All arrays are indexed by
+// CityId and are only valid for a city whose stamp equals the current
+// generation, so starting a new query is O(1) instead of re-initializing
+// every node. Buffers keep their capacity between queries, which means a
+// warmed-up workspace searches without touching the heap.
+struct SearchWorkspace {
+    uint32_t generation;
+    vector<uint32_t> stamp;
+    size_t settled; // cities taken off the queue by the last search
+
+    // Lower bound from each city to the target (A*)
+    vector<double> potential;
+
+    // Dijkstra
+    vector<double> distance;
+    vector<double> secondaryDistance;
+    vector<vector<pair<CityId, uint32_t>>> parentCandidates; // (parent city, edge)
+    BinaryCityQueue binaryQueue;
+    QuadHeap quadQueue;
+    RadixHeap radixQueue;
+
+    // Forward half of bidirectional searches
+    vector<PQNode> heap;
+
+    // Backward half of bidirectional searches (parents point toward the target)
+    vector<double> backwardDistance;
+    vector<double> backwardSecondary;
+    vector<vector<pair<CityId, uint32_t>>> backwardParents; // (next city, edge)
+    vector<PQNode> backwardHeap;
+
+    // BFS
+    vector<int> hops;
+    vector<CityId> parent;
+    vector<uint32_t> parentEdge;
+    vector<CityId> queue;
+
+    // Backward half of bidirectional BFS (parent edges lead toward the target)
+    vector<int> backwardHops;
+    vector<uint32_t> backwardParentEdge;
+    vector<CityId> backwardQueue;
+
+    // Pareto labels: the pool, each city's non-dominated set and the queue
+    vector<Label> labelPool;
+    vector<vector<uint32_t>> labels;
+    vector<PQElement> labelHeap;
+
+    // N-criteria Pareto labels. Buckets are reused across queries: only the
+    // first criteriaBucketCount[u] entries of criteriaBuckets[u] are live.
+    vector<CriteriaLabel> criteriaPool;
+    vector<vector<CriteriaBucket>> criteriaBuckets;
+    vector<uint32_t> criteriaBucketCount;
+    vector<CriteriaQueueEntry> criteriaHeap;
+
+    // Connection scan: earliest arrival minute at each city and the scan
+    // position of the connection that arrives then
+    vector<int32_t> arrivalTime;
+    vector<uint32_t> arrivalConnection;
+
+    // K shortest paths: the prefix tree of generated routes, the exact
+    // distance from every city to the target, the cities a spur search must
+    // avoid and the flights of the last spur route. Kept across the spur
+    // searches of one query (begin() does not reset them).
+    vector<PathNode> pathTree;
+    vector<double> targetDistance;
+    vector<char> blockedCity;
+    vector<uint32_t> spurEdges;
+
+    // Routes of the current query and the state of their enumeration: the
+    // (city, next parent candidate) stack and the edges along it
+    PathArena paths;
+    PathArena backwardPaths;
+    vector<pair<CityId, uint32_t>> pathStack;
+    vector<uint32_t> stackEdges;
+
+    SearchWorkspace() : generation(0), settled(0) {}
+
+    // Start a new query on a graph with cityCount cities
+    void begin(size_t cityCount) {
+        if (stamp.size() < cityCount) {
+            stamp.resize(cityCount, 0);
+            potential.resize(cityCount);
+            distance.resize(cityCount);
+            secondaryDistance.resize(cityCount);
+            parentCandidates.resize(cityCount);
+            backwardDistance.resize(cityCount);
+            backwardSecondary.resize(cityCount);
+            backwardParents.resize(cityCount);
+            hops.resize(cityCount);
+            parent.resize(cityCount);
+            parentEdge.resize(cityCount);
+            backwardHops.resize(cityCount);
+            backwardParentEdge.resize(cityCount);
+            labels.resize(cityCount);
+            criteriaBuckets.resize(cityCount);
+            criteriaBucketCount.resize(cityCount);
+            arrivalTime.resize(cityCount);
+            arrivalConnection.resize(cityCount);
+            blockedCity.resize(cityCount, 0);
+        }
+        if (++generation == 0) {
+            // Counter wrapped: stamps from 2^32 queries ago would look current
+            fill(stamp.begin(), stamp.end(), 0);
+            generation = 1;
+        }
+        heap.clear();
+        backwardHeap.clear();
+        queue.clear();
+        backwardQueue.clear();
+        labelPool.clear();
+        labelHeap.clear();
+        criteriaPool.clear();
+        criteriaHeap.clear();
+        paths.clear();
+        backwardPaths.clear();
+        settled = 0;
+    }
+
+    bool reached(CityId u) const { return stamp[u] == generation; }
+
+    // Reset the per-city state of u the first time this query reaches it
+    void reach(CityId u) {
+        if (stamp[u] == generation) return;
+        stamp[u] = generation;
+        potential[u] = 0;
+        distance[u] = INF;
+        secondaryDistance[u] = INF;
+        parentCandidates[u].clear();
+        backwardDistance[u] = INF;
+        backwardSecondary[u] = INF;
+        backwardParents[u].clear();
+        hops[u] = -1;
+        parent[u] = INVALID_CITY;
+        parentEdge[u] = NO_EDGE;
+        backwardHops[u] = -1;
+        backwardParentEdge[u] = NO_EDGE;
+        labels[u].clear();
+        criteriaBucketCount[u] = 0;
+        arrivalTime[u] = NO_TIME;
+        arrivalConnection[u] = NO_EDGE;
+    }
+};
+// =========================================================
+
+//--------------------EOF DATA STRUCTURES---------------------------
+
+// CLI Interface
+void displayMenu() {
+    cout << "\n--------------------------------------------------\n";
+    cout << "|      AIRLINE BOOKING SYSTEM                     |\n";
+    cout << "--------------------------------------------------\n";
+    cout << "1. Search Flights (Cheapest Route)\n";
+    cout << "2. Search Flights (Fastest Route)\n";
+    cout << "3. Search Flights (Minimum Stops)\n";
+    cout << "4. Search Flights (Pareto-Optimal Routes)  <-- NEW\n";
+    cout << "5. Compare All Three Optimal Options\n";
+    cout << "6. Display Network Stats\n";
+    cout << "7. List All Cities\n";
+    cout << "8. City Information\n";
+    cout << "9. Display ENTIRE Flight Graph\n";
+    cout << "10. Search Flights (Pareto: Cost, Time and Stops)\n";
+    cout << "11. Search Flights (Earliest Arrival by Timetable)\n";
+    cout << "12. Search Flights with Restrictions (Seats, Airlines, Transit)\n";
+    cout << "13. Search Flights (Top 20 Alternatives)\n";
+    cout << "0. Exit\n";
+    cout << string(48, '-') << "\n";
+    cout << "Enter choice: ";
+}
+
+// Build the route that takes the flights (edge IDs) in [first, last) in order from source
+Route buildRoute(const FlatGraph& graph, CityId source, const uint32_t* first, const uint32_t* last) {
+    Route route;
+    route.cities.reserve(last - first + 1);
+    route.flights.reserve(last - first);
+    route.cities.push_back(graph.cityCodes[source]);
+    for (const uint32_t* e = first; e != last; ++e) {
+        Flight flight = graph.flight(*e);
+        route.cities.push_back(graph.cityCodes[graph.edgeDest[*e]]);
+        route.totalCost += flight.cost;
+        route.totalDuration += flight.duration;
+        route.flights.push_back(move(flight));
+    }
+    route.stops = max(0, (int)route.flights.size() - 1);
+    return route;
+}
+
+Route buildRoute(const FlatGraph& graph, CityId source, const vector<uint32_t>& edges) {
+    return buildRoute(graph, source, edges.data(), edges.data() + edges.size());
+}
+
+// Routes for every path of an arena, all starting at source
+void buildRoutes(const FlatGraph& graph, CityId source, const PathArena& paths, vector<Route>& routes) {
+    routes.reserve(routes.size() + paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        routes.push_back(buildRoute(graph, source, paths.begin(i), paths.end(i)));
+    }
+}
+
+// Add to paths every arc sequence that leads from city to stop through the
+// optimal parent candidates of a search, depth first without recursion.
+// Paths with a common prefix share it on the stack until they branch; each
+// one is written in walk order, or reversed with inTravelOrder when the
+// candidates point back toward the source.
+void collectArcPaths(
+    CityId city,
+    CityId stop,
+    const vector<vector<pair<CityId, uint32_t>>>& parents,
+    bool inTravelOrder,
+    SearchWorkspace& ws,
+    PathArena& paths
+) {
+    vector<pair<CityId, uint32_t>>& stack = ws.pathStack;
+    vector<uint32_t>& walked = ws.stackEdges;
+    stack.assign(1, { city, 0 });
+    walked.clear();
+
+    while (!stack.empty()) {
+        pair<CityId, uint32_t>& top = stack.back();
+        const vector<pair<CityId, uint32_t>>& candidates = parents[top.first];
+        if (top.first == stop || top.second == candidates.size()) {
+            if (top.first == stop) {
+                if (inTravelOrder) paths.edges.insert(paths.edges.end(), walked.rbegin(), walked.rend());
+                else paths.edges.insert(paths.edges.end(), walked.begin(), walked.end());
+                paths.close();
+            }
+            stack.pop_back();
+            if (!walked.empty()) walked.pop_back();
+            continue;
+        }
+
+        const pair<CityId, uint32_t>& candidate = candidates[top.second++];
+        walked.push_back(candidate.second);
+        stack.push_back({ candidate.first, 0 });
+    }
+}
+
+
+// Default memory budget of the route result cache
+const size_t DEFAULT_CACHE_BYTES = size_t(64) << 20;
+
+// Bounded least-recently-used cache of search results keyed by objective,
+// source and destination. Keys are spread over shards that each have their
+// own lock, LRU list and share of the byte budget, so concurrent batch
+// workers rarely contend. Results are tagged with the generation (graph
+// version) they were computed on: invalidate() empties the cache and starts
+// a new generation, and lookups and stores for any other generation miss, so
+// a search still running on an older graph version never sees or leaves a
+// result of the wrong version.
+class RouteCache {
+private:
+    struct Entry {
+        string key;
+        shared_ptr<const vector<Route>> routes; // immutable, so hits share it without copying
+        size_t bytes;
+        uint64_t generation;
+    };
+
+    struct Shard {
+        mutex lock;
+        list<Entry> entries; // most recently used first
+        unordered_map<string, list<Entry>::iterator> index;
+        size_t bytes;
+
+        Shard() : bytes(0) {}
+    };
+
+    static const size_t SHARD_COUNT = 16;
+    Shard shards[SHARD_COUNT];
+    size_t shardBudget;
+    atomic<uint64_t> generation;
+    atomic<uint64_t> hits;
+    atomic<uint64_t> misses;
+    atomic<uint64_t> evictions;
+
+    Shard& shardFor(const string& key) {
+        return shards[hash<string>()(key) % SHARD_COUNT];
+    }
+
+    // Approximate heap footprint of a cached result
+    static size_t resultBytes(const string& key, const vector<Route>& routes) {
+        size_t bytes = sizeof(Entry) + 2 * key.size() + 64; // key is held by the entry and the index
+        for (const Route& route : routes) {
+            bytes += sizeof(Route);
+            for (const string& city : route.cities) bytes += sizeof(string) + city.capacity();
+            for (const Flight& f : route.flights) {
+                bytes += sizeof(Flight) + f.flightNo.capacity() + f.destination.capacity() +
+                    f.airline.capacity() + f.departureTime.capacity() + f.arrivalTime.capacity() +
+                    f.aircraft.capacity() + f.frequency.capacity();
+            }
+        }
+        return bytes;
+    }
+
+public:
+    explicit RouteCache(size_t maxBytes = DEFAULT_CACHE_BYTES)
+        : shardBudget(maxBytes / SHARD_COUNT), generation(0), hits(0), misses(0), evictions(0) {}
+
+    RouteCache(const RouteCache&) = delete;
+    RouteCache& operator=(const RouteCache&) = delete;
+
+    // variant tells restricted searches apart (see RouteFilter::cacheKey())
+    static string makeKey(char objective, const string& source, const string& dest, const string& variant = "") {
+        string key;
+        key.reserve(source.size() + dest.size() + 2);
+        key += objective;
+        key += source;
+        key += '\0';
+        key += dest;
+        if (!variant.empty()) {
+            key += '\0';
+            key += variant;
+        }
+        return key;
+    }
+
+    bool enabled() const { return shardBudget > 0; }
+
+    // Change the memory budget (0 disables the cache); drops all entries
+    void setCapacity(size_t maxBytes) {
+        invalidate(generation);
+        shardBudget = maxBytes / SHARD_COUNT;
+    }
+
+    // The result cached for key during resultGeneration (null if none), marked
+    // most recently used. Only the pointer is copied under the shard lock; it
+    // keeps the result alive after an eviction.
+    shared_ptr<const vector<Route>> lookup(const string& key, uint64_t resultGeneration) {
+        Shard& shard = shardFor(key);
+        lock_guard<mutex> guard(shard.lock);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end() || it->second->generation != resultGeneration) {
+            misses++;
+            return nullptr;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        hits++;
+        return it->second->routes;
+    }
+
+    // Remember a result computed during resultGeneration, evicting the least
+    // recently used entries of its shard to stay within budget
+    void store(const string& key, shared_ptr<const vector<Route>> routes, uint64_t resultGeneration) {
+        size_t bytes = resultBytes(key, *routes);
+        if (bytes > shardBudget) return;
+
+        Shard& shard = shardFor(key);
+        lock_guard<mutex> guard(shard.lock);
+        if (resultGeneration != generation) return; // graph changed while searching
+        if (shard.index.count(key)) return;         // stored by another thread meanwhile
+
+        while (shard.bytes + bytes > shardBudget && !shard.entries.empty()) {
+            const Entry& oldest = shard.entries.back();
+            shard.bytes -= oldest.bytes;
+            shard.index.erase(oldest.key);
+            shard.entries.pop_back();
+            evictions++;
+        }
+        shard.entries.push_front({ key, move(routes), bytes, resultGeneration });
+        shard.index[key] = shard.entries.begin();
+        shard.bytes += bytes;
+    }
+
+    // Drop every entry and cache results of newGeneration from now on, e.g.
+    // because a new graph version was published
+    void invalidate(uint64_t newGeneration) {
+        generation = newGeneration;
+        for (Shard& shard : shards) {
+            lock_guard<mutex> guard(shard.lock);
+            shard.entries.clear();
+            shard.index.clear();
+            shard.bytes = 0;
+        }
+    }
+
+    uint64_t hitCount() const { return hits; }
+    uint64_t missCount() const { return misses; }
+    uint64_t evictionCount() const { return evictions; }
+
+    void usage(size_t& entries, size_t& bytes) {
+        entries = 0;
+        bytes = 0;
+        for (Shard& shard : shards) {
+            lock_guard<mutex> guard(shard.lock);
+            entries += shard.index.size();
+            bytes += shard.bytes;
+        }
+    }
+};
+
+// Flight waiting to be merged into the frozen graph
+struct PendingFlight {
+    CityId source;
+    CityId destination;
+    Flight flight;
+    bool cancelled = false; // cancelled before it was merged
+};
+
+// Seat or fare change to an edge of the frozen graph, applied at the next freeze()
+struct StagedChange {
+    uint32_t edge;
+    bool fare;    // true: cost becomes value, false: seatsAvailable does
+    double value;
+};
+
+// Flights parsed by one worker of the parallel loader. Cities are interned
+// locally and remapped to graph-wide IDs when the chunks are merged.
+struct FlightChunk {
+    size_t start;                  // file offset of the first element
+    size_t end;                    // elements starting at or after this belong to the next chunk
+    vector<string> cityCodes;      // local CityId -> IATA code
+    unordered_map<string, CityId> cityIds;
+    vector<PendingFlight> flights; // source/destination are local IDs
+    vector<size_t> skipped;        // offsets of incomplete flight objects
+    size_t stopOffset;             // first element start at or after 'end'
+    bool reachedEnd;               // saw the end of the flights array
+    bool failed;
+    size_t errorOffset;
+
+    FlightChunk() : start(0), end(0), stopOffset(0), reachedEnd(false), failed(false), errorOffset(0) {}
+
+    CityId intern(const string& code) {
+        auto it = cityIds.find(code);
+        if (it != cityIds.end()) return it->second;
+
+        CityId id = (CityId)cityCodes.size();
+        cityCodes.push_back(code);
+        cityIds[code] = id;
+        return id;
+    }
+};
+
+// Main Flight Graph class
+class FlightGraph {
+private:
+    unordered_map<string, City> cities;
+
+    // Interned city codes: every airport seen in a flight gets a dense CityId
+    vector<string> cityCodes;
+    unordered_map<string, CityId> cityIds;
+
+    // Flights added since the last freeze()
+    vector<PendingFlight> pendingFlights;
+
+    // Inventory updates since the last freeze(): seat and fare changes and
+    // cancelled edges of the frozen graph (changes to pending flights are
+    // made on the pending flight directly)
+    vector<StagedChange> stagedChanges;
+    unordered_set<uint32_t> cancelledEdges;
+
+    // Flight number -> edge of the frozen graph and -> index in pendingFlights.
+    // The edge index is built on first use after each rebuild; the pending
+    // index is extended lazily over flights appended since it was last used.
+    unordered_map<string, uint32_t> flightIndex;
+    bool flightIndexBuilt;
+    unordered_map<string, size_t> pendingIndex;
+    size_t pendingIndexed;
+
+    // CSR form used by all searches. Writers (loading, freeze(), landmark and
+    // hierarchy preprocessing) build the next version privately and swap it in
+    // with publish(); each search pins the version it starts on, and a version
+    // is freed once the last search holding it finishes. Accessed through
+    // atomic_load/atomic_store only.
+    shared_ptr<const FlatGraph> current;
+    uint64_t publishedVersions;
+
+    // Scratch memory for searches made through the single-threaded API
+    SearchWorkspace defaultWorkspace;
+
+    // Results of cheapest, fastest and Pareto queries; the const search
+    // variants fill it, so it is internally synchronized
+    mutable RouteCache resultCache;
+
+    // A* settings; the great-circle bounds are rebuilt at the next freeze()
+    // whenever cities or flights change, landmark tables must be prepared again
+    bool goalDirectedSearch;
+
+    // Search from both ends for point-to-point queries without a hierarchy
+    bool bidirectionalSearch;
+
+    // Time findAlternativeRoutes() may spend on one query
+    chrono::milliseconds alternativesBudget;
+
+    // Queue of the single-label searches
+    QueueKind searchQueue;
+
+    // Round fares to whole cents and durations to whole minutes at ingest
+    bool integerWeights;
+
+    // buildHierarchies() was called, and the landmarks of the last tables
+    // built or loaded; refreshPreprocessing() rebuilds what updates made stale
+    bool hierarchiesRequested;
+    vector<CityId> landmarkCities;
+
+    // Time the last landmark and hierarchy preprocessing took
+    double preprocessingSeconds;
+
+    // City records changed since the great-circle bounds and the timetable were built
+    bool cityTablesDirty;
+
+    CityId internCity(const string& code) {
+        auto it = cityIds.find(code);
+        if (it != cityIds.end()) return it->second;
+
+        CityId id = (CityId)cityCodes.size();
+        cityCodes.push_back(code);
+        cityIds[code] = id;
+        return id;
+    }
+
+    // Parse the members of one flight object (the reader is just past its '{').
+    // The source airport is returned separately since Flight only stores the destination.
+    static bool readFlightObject(JsonReader& reader, string& key, string& source, Flight& flight) {
+        bool firstKey = true;
+        while (reader.nextKey(key, firstKey)) {
+            bool ok;
+            if (key == "source") ok = reader.readStringField(source);
+            else if (!readFlightField(reader, key, flight, ok)) ok = reader.skipValue();
+            if (!ok) break;
+        }
+        return !reader.failed();
+    }
+
+    // Build the flight number index of the frozen graph if needed
+    void indexFrozenFlights() {
+        if (flightIndexBuilt) return;
+        shared_ptr<const FlatGraph> version = currentVersion();
+        flightIndex.clear();
+        flightIndex.reserve(version->flightCount());
+        for (uint32_t e = 0; e < version->flightCount(); e++) {
+            flightIndex.emplace(version->flightNumber(e), e); // the first flight wins if a number repeats
+        }
+        flightIndexBuilt = true;
+    }
+
+    // Find the live flight with this number: either pendingFlights[pendingSlot]
+    // (edge = NO_EDGE) or frozen edge 'edge' (pendingSlot = SIZE_MAX)
+    bool locateFlight(const string& flightNo, size_t& pendingSlot, uint32_t& edge) {
+        for (; pendingIndexed < pendingFlights.size(); pendingIndexed++) {
+            const PendingFlight& pending = pendingFlights[pendingIndexed];
+            if (!pending.cancelled) pendingIndex.emplace(pending.flight.flightNo, pendingIndexed);
+        }
+
+        pendingSlot = SIZE_MAX;
+        edge = NO_EDGE;
+        auto pending = pendingIndex.find(flightNo);
+        if (pending != pendingIndex.end()) {
+            pendingSlot = pending->second;
+            return true;
+        }
+
+        indexFrozenFlights();
+        auto frozenEdge = flightIndex.find(flightNo);
+        if (frozenEdge == flightIndex.end() || cancelledEdges.count(frozenEdge->second)) return false;
+        edge = frozenEdge->second;
+        return true;
+    }
+
+    // Apply the staged seat and fare changes to the unpublished version g;
+    // remap gives the new slot of each old edge after a rebuild (NO_EDGE if
+    // it was cancelled)
+    void applyStagedChanges(FlatGraph& g, const vector<uint32_t>* remap) {
+        bool faresChanged = false;
+        bool faresLowered = false;
+        for (const StagedChange& change : stagedChanges) {
+            uint32_t e = remap ? (*remap)[change.edge] : change.edge;
+            if (e == NO_EDGE) continue;
+
+            if (change.fare) {
+                double weight = g.costWeight(change.value);
+                faresChanged = true;
+                faresLowered = faresLowered || weight < g.edgeCostData[e];
+                g.edgeCostData[e] = weight;
+            }
+            else {
+                g.edgeSeats[e] = (int32_t)change.value;
+            }
+        }
+        stagedChanges.clear();
+
+        // Landmark bounds stay valid (and consistent) when fares only go up.
+        // Cost shortcuts carry the old fares and the duration hierarchy breaks
+        // ties on them, so any fare change leaves both hierarchies stale.
+        // Searches run without them until refreshPreprocessing().
+        if (faresLowered) g.landmarkTables = nullptr;
+        if (faresChanged) {
+            g.costHierarchy = nullptr;
+            g.durationHierarchy = nullptr;
+        }
+    }
+
+    // Make next the version that searches see from now on. Searches already
+    // running finish on the version they pinned; the replaced version is
+    // freed when the last of them lets go of it.
+    void publish(shared_ptr<FlatGraph> next) {
+        next->version = ++publishedVersions;
+        uint64_t generation = next->version;
+        atomic_store(&current, shared_ptr<const FlatGraph>(move(next)));
+        resultCache.invalidate(generation);
+    }
+
+    // Worker body of the parallel loader: parse every flight whose object
+    // starts inside [chunk.start, chunk.end)
+    static void parseFlightChunk(const string& filename, FlightChunk& chunk) {
+        ifstream file(filename, ios::binary);
+        if (!file.is_open()) {
+            chunk.failed = true;
+            chunk.errorOffset = chunk.start;
+            return;
+        }
+        file.seekg((streamoff)chunk.start);
+
+        JsonReader reader(file, chunk.start);
+        bool firstFlight = true;
+        string key;
+
+        while (true) {
+            if (!reader.nextElement(firstFlight)) {
+                chunk.reachedEnd = !reader.failed();
+                break;
+            }
+
+            size_t objectStart = reader.offset();
+            if (objectStart >= chunk.end) {
+                chunk.stopOffset = objectStart;
+                break;
+            }
+            if (!reader.consume('{')) {
+                reader.skipValue(); // not an object
+                continue;
+            }
+
+            string source;
+            Flight flight;
+            if (!readFlightObject(reader, key, source, flight)) break;
+
+            if (!source.empty() && !flight.destination.empty() && !flight.flightNo.empty()) {
+                PendingFlight pending;
+                pending.source = chunk.intern(source);
+                pending.destination = chunk.intern(flight.destination);
+                pending.flight = move(flight);
+                chunk.flights.push_back(move(pending));
+            }
+            else {
+                chunk.skipped.push_back(objectStart);
+            }
+        }
+
+        if (reader.failed()) {
+            chunk.failed = true;
+            chunk.errorOffset = reader.offset();
+        }
+    }
+
+    // Precompute per-city coordinates and the fastest observed ground speed
+    // for the A* bound. The bound is only admissible if every flight's
+    // endpoints have coordinates, so it is disabled (0) otherwise.
+    void buildGeoBounds(FlatGraph& g) {
+
+        size_t n = g.cityCount();
+        g.cityLatitude.assign(n, 0);
+        g.cityLongitude.assign(n, 0);
+        g.cityCosLatitude.assign(n, 1);
+        g.maxCruiseSpeed = 0;
+
+        vector<bool> located(n, false);
+        for (CityId u = 0; u < n; u++) {
+            auto it = cities.find(g.cityCodes[u]);
+            if (it == cities.end()) continue;
+            g.cityLatitude[u] = it->second.latitude * PI / 180;
+            g.cityLongitude[u] = it->second.longitude * PI / 180;
+            g.cityCosLatitude[u] = cos(g.cityLatitude[u]);
+            located[u] = true;
+        }
+
+        double maxSpeed = 0;
+        for (CityId u = 0; u < n; u++) {
+            for (uint32_t e = g.firstEdge[u]; e < g.firstEdge[u + 1]; e++) {
+                CityId v = g.edgeDest[e];
+                if (!located[u] || !located[v] || g.edgeDuration[e] <= 0) {
+                    return; // cannot bound this flight
+                }
+                double km = haversineKm(g.cityLatitude[u], g.cityLongitude[u], g.cityCosLatitude[u],
+                    g.cityLatitude[v], g.cityLongitude[v], g.cityCosLatitude[v]);
+                maxSpeed = max(maxSpeed, km / g.edgeDuration[e]);
+            }
+        }
+
+        // Small margin so rounding in the haversine never overestimates
+        g.maxCruiseSpeed = maxSpeed * (1 + 1e-6);
+    }
+
+    // Parse each city's time zone once into the UTC offset table, look up its
+    // minimum connection time, then rebuild the UTC schedule and timetable.
+    // Cities without a record or a parseable timezone are taken to be on UTC.
+    void buildTimetable(FlatGraph& g) {
+        cityTablesDirty = false;
+
+        size_t n = g.cityCount();
+        g.cityUtcOffset.assign(n, 0);
+        g.minConnectionMinutes.assign(n, DEFAULT_MIN_CONNECTION_MINUTES);
+        for (CityId u = 0; u < n; u++) {
+            auto it = cities.find(g.cityCodes[u]);
+            if (it == cities.end()) continue;
+
+            int offset;
+            parseUtcOffset(it->second.timezone, offset);
+            g.cityUtcOffset[u] = (int16_t)offset;
+            g.minConnectionMinutes[u] = it->second.minConnectionMinutes;
+        }
+
+        g.buildSchedule();
+    }
+
+public:
+    FlightGraph() : flightIndexBuilt(false), pendingIndexed(0), current(make_shared<FlatGraph>()),
+        publishedVersions(0), goalDirectedSearch(true), bidirectionalSearch(false),
+        alternativesBudget(DEFAULT_ALTERNATIVES_BUDGET_MS), searchQueue(DEFAULT_QUEUE), integerWeights(false),
+        hierarchiesRequested(false), preprocessingSeconds(0), cityTablesDirty(true) {}
+
+    // Parse one member of a flight object into flight (everything except
+    // "source"). Returns false if key is not a flight field; ok reports
+    // whether the value could be read.
+    static bool readFlightField(JsonReader& reader, const string& key, Flight& flight, bool& ok) {
+        if (key == "destination") ok = reader.readStringField(flight.destination);
+        else if (key == "flight_number") ok = reader.readStringField(flight.flightNo);
+        else if (key == "airline") ok = reader.readStringField(flight.airline);
+        else if (key == "departure_time") ok = reader.readStringField(flight.departureTime);
+        else if (key == "arrival_time") ok = reader.readStringField(flight.arrivalTime);
+        else if (key == "aircraft") ok = reader.readStringField(flight.aircraft);
+        else if (key == "duration_hours") ok = reader.readNumberField(flight.duration);
+        else if (key == "cost_usd") ok = reader.readNumberField(flight.cost);
+        else if (key == "seats_available") {
+            double seats = 0;
+            ok = reader.readNumberField(seats);
+            flight.seatsAvailable = (int)seats;
+        }
+        else if (key == "frequency") ok = reader.readStringField(flight.frequency);
+        else return false;
+        return true;
+    }
+
+    // Add a flight to the graph. It becomes visible to searches at the next freeze().
+    void addFlight(string source, string dest, string flightNo,
+        double duration, double cost, string airline,
+        string depTime = "", string arrTime = "",
+        string aircraft = "", int seats = 0, string frequency = "") {
+        PendingFlight pending;
+        pending.source = internCity(source);
+        pending.destination = internCity(dest);
+        pending.flight = Flight(dest, flightNo, duration, cost, airline,
+            depTime, arrTime, aircraft, seats, frequency);
+        pendingFlights.push_back(move(pending));
+    }
+
+    // Inventory updates addressed by flight number. Staging one is O(1) on
+    // average; they become visible to searches at the next freeze(), so
+    // searches running on the frozen graph meanwhile keep a consistent view.
+    // Publishing a batch of them copies the edge columns of the current
+    // version, O(V + E) per freeze() however few flights changed. A lower
+    // fare drops the landmark tables and any fare change drops the
+    // hierarchies until refreshPreprocessing(). Each returns false if no live
+    // flight has that number.
+    bool updateSeats(const string& flightNo, int seats) {
+        size_t pendingSlot;
+        uint32_t edge;
+        if (!locateFlight(flightNo, pendingSlot, edge)) return false;
+
+        if (edge == NO_EDGE) pendingFlights[pendingSlot].flight.seatsAvailable = seats;
+        else stagedChanges.push_back({ edge, false, (double)seats });
+        return true;
+    }
+
+    bool updateFare(const string& flightNo, double cost) {
+        size_t pendingSlot;
+        uint32_t edge;
+        if (!locateFlight(flightNo, pendingSlot, edge)) return false;
+
+        if (edge == NO_EDGE) pendingFlights[pendingSlot].flight.cost = cost;
+        else stagedChanges.push_back({ edge, true, cost });
+        return true;
+    }
+
+    bool cancelFlight(const string& flightNo) {
+        size_t pendingSlot;
+        uint32_t edge;
+        if (!locateFlight(flightNo, pendingSlot, edge)) return false;
+
+        if (edge == NO_EDGE) {
+            pendingFlights[pendingSlot].cancelled = true;
+            pendingIndex.erase(flightNo);
+        }
+        else {
+            cancelledEdges.insert(edge);
+        }
+        return true;
+    }
+
+    // True if a live flight (frozen or pending) has this number
+    bool hasFlight(const string& flightNo) {
+        size_t pendingSlot;
+        uint32_t edge;
+        return locateFlight(flightNo, pendingSlot, edge);
+    }
+
+    // Merge pending flights and inventory updates into a new graph version
+    // and publish it. Seat and fare changes alone are applied to a copy of
+    // the current version that shares its flight side table; new flights and
+    // cancellations rebuild the arrays once. Edges stay grouped by source in
+    // insertion order, so search results match the order flights were added in.
+    void freeze() {
+        shared_ptr<const FlatGraph> base = currentVersion();
+        const FlatGraph& old = *base;
+        bool rebuild = !pendingFlights.empty() || !cancelledEdges.empty() ||
+            old.cityCount() != cityCodes.size() || (old.isMapped() && !stagedChanges.empty());
+        if (!rebuild) {
+            if (stagedChanges.empty() && !cityTablesDirty) return;
+
+            shared_ptr<FlatGraph> next = old.clone();
+            applyStagedChanges(*next, nullptr);
+            if (cityTablesDirty) {
+                buildGeoBounds(*next);
+                buildTimetable(*next);
+            }
+            publish(next);
+            return;
+        }
+
+        size_t oldCities = old.cityCount();
+        size_t cityCount = cityCodes.size();
+
+        // New slot of every old edge (NO_EDGE once cancelled)
+        vector<uint32_t> remap(old.flightCount(), 0);
+        for (uint32_t e : cancelledEdges) {
+            remap[e] = NO_EDGE;
+        }
+
+        // Count outbound edges per city (shifted by one for the prefix sum)
+        vector<uint32_t> firstEdge(cityCount + 1, 0);
+        for (size_t u = 0; u < oldCities; u++) {
+            firstEdge[u + 1] = old.firstEdge[u + 1] - old.firstEdge[u];
+        }
+        for (uint32_t e : cancelledEdges) {
+            firstEdge[old.edgeSource[e] + 1]--;
+        }
+        for (const PendingFlight& pending : pendingFlights) {
+            if (!pending.cancelled) firstEdge[pending.source + 1]++;
+        }
+        for (size_t u = 0; u < cityCount; u++) {
+            firstEdge[u + 1] += firstEdge[u];
+        }
+        size_t edgeCount = firstEdge[cityCount];
+
+        // Hierarchies refer to the old edge slots and are not carried over.
+        // Landmark bounds stay valid when flights were only cancelled; new
+        // flights may beat them. Weights keep the units they were loaded in.
+        shared_ptr<FlatGraph> next = make_shared<FlatGraph>();
+        next->integerWeights = integerWeights;
+        bool flightsAdded = any_of(pendingFlights.begin(), pendingFlights.end(),
+            [](const PendingFlight& pending) { return !pending.cancelled; });
+        if (!flightsAdded && cityCount == oldCities) next->landmarkTables = old.landmarkTables;
+
+        vector<CityId> edgeDest(edgeCount);
+        vector<double> edgeCost(edgeCount);
+        vector<double> edgeDuration(edgeCount);
+        vector<int32_t> edgeSeats(edgeCount);
+        vector<uint32_t> cursor(firstEdge.begin(), firstEdge.end() - 1);
+
+        // Old records keep their offsets into a copy of the old string pool;
+        // strings of new flights are pooled after it
+        shared_ptr<FlightMetadata> metadata = make_shared<FlightMetadata>();
+        metadata->flights.resize(edgeCount);
+        StringPool strings;
+        strings.data.assign(old.stringPool ? old.stringPool : "", old.stringPoolSize);
+
+        // Existing edges keep their relative order (copied, since searches
+        // may still be reading the old version)...
+        for (size_t u = 0; u < oldCities; u++) {
+            for (uint32_t e = old.firstEdge[u]; e < old.firstEdge[u + 1]; e++) {
+                if (remap[e] == NO_EDGE) continue;
+                uint32_t slot = cursor[u]++;
+                remap[e] = slot;
+                edgeDest[slot] = old.edgeDest[e];
+                edgeCost[slot] = old.edgeCost[e];
+                edgeDuration[slot] = old.edgeDuration[e];
+                edgeSeats[slot] = old.edgeSeats[e];
+                metadata->flights[slot] = old.flightInfo[e];
+            }
+        }
+        // ...and new edges are appended after them
+        for (PendingFlight& pending : pendingFlights) {
+            if (pending.cancelled) continue;
+            uint32_t slot = cursor[pending.source]++;
+            edgeDest[slot] = pending.destination;
+            edgeCost[slot] = next->costWeight(pending.flight.cost);
+            edgeDuration[slot] = next->durationWeight(pending.flight.duration);
+            edgeSeats[slot] = pending.flight.seatsAvailable;
+            metadata->flights[slot] = packFlight(pending.flight, strings, false);
+        }
+        if (strings.data.size() > numeric_limits<uint32_t>::max()) {
+            cerr << "Warning: Flight metadata exceeds the 4 GB string pool limit\n";
+        }
+        metadata->pool = move(strings.data);
+
+        next->cityCodes = cityCodes;
+        next->cityIds = cityIds;
+        next->firstEdgeData = move(firstEdge);
+        next->edgeDestData = move(edgeDest);
+        next->edgeCostData = move(edgeCost);
+        next->edgeDurationData = move(edgeDuration);
+        next->edgeSeats = move(edgeSeats);
+        next->flightMetadata = metadata;
+        next->attachOwnedColumns();
+        next->buildReverseIndex();
+        next->buildAirlineIndex();
+        applyStagedChanges(*next, &remap);
+        buildGeoBounds(*next);
+        buildTimetable(*next);
+        publish(next);
+
+        pendingFlights.clear();
+        pendingFlights.shrink_to_fit();
+        cancelledEdges.clear();
+        flightIndex.clear();
+        flightIndexBuilt = false;
+        pendingIndex.clear();
+        pendingIndexed = 0;
+    }
+
+    // Latest published graph version; holding the pointer keeps that version
+    // alive (and unchanged) however many versions are published meanwhile
+    shared_ptr<const FlatGraph> currentVersion() const {
+        return atomic_load(&current);
+    }
+
+    // Latest version after merging pending flights and updates (see freeze())
+    shared_ptr<const FlatGraph> frozen() {
+        freeze();
+        return currentVersion();
+    }
+
+    // Add city information
+    void addCity(const City& city) {
+        cities[city.code] = city;
+        cityTablesDirty = true;
+    }
+
+    // Use A* for cheapest/fastest-route queries (on by default). Fastest routes
+    // use the great-circle bound; both use landmark bounds once prepared.
+    void setGoalDirectedSearch(bool enabled) {
+        goalDirectedSearch = enabled;
+    }
+
+    // Answer cheapest, fastest and minimum-stop queries by searching from both
+    // ends at once (off by default; contraction hierarchies take precedence)
+    void setBidirectionalSearch(bool enabled) {
+        bidirectionalSearch = enabled;
+    }
+
+    // Latency budget of one alternative-routes query in milliseconds
+    void setAlternativesBudget(int milliseconds) {
+        alternativesBudget = chrono::milliseconds(milliseconds);
+    }
+
+    // Priority queue of the cheapest, fastest, one-to-all and alternative-route
+    // searches (see QueueKind); all give the same routes
+    void setSearchQueue(QueueKind kind) {
+        searchQueue = kind;
+    }
 
-public:
-    // Add a flight to the graph (unchanged)
-    void addFlight(string source, string dest, string flightNo,
-        double duration, double cost, string airline,
-        string depTime = "", string arrTime = "",
-        string aircraft = "", int seats = 0) {
-        adjList[source].push_back(Flight(dest, flightNo, duration, cost, airline,
-            depTime, arrTime, aircraft, seats));
+    // Store fares as whole cents and durations as whole minutes, so route
+    // totals are exact and equally good routes tie exactly. Call before
+    // loading: flights keep the units they were loaded in, and a snapshot
+    // brings its own.
+    void setIntegerWeights(bool enabled) {
+        integerWeights = enabled;
     }
 
-    // Add city information (unchanged)
-    void addCity(const City& city) {
-        cities[city.code] = city;
+    // Memory budget of the result cache in bytes (0 disables it)
+    void setResultCacheSize(size_t bytes) {
+        resultCache.setCapacity(bytes);
+    }
+
+    RouteCache& routeCache() const {
+        return resultCache;
     }
 
-    // Load cities from JSON file (unchanged - kept for completeness)
+    // Load cities from JSON file (streamed in a single pass)
     bool loadCitiesFromJSON(const string& filename) {
-        // Read entire file into string
-        ifstream file(filename);
+        ifstream file(filename, ios::binary);
         if (!file.is_open()) {
             cerr << "Error: Could not open " << filename << endl;
             cerr << "   Make sure the file exists in the current directory.\n";
             return false;
         }
 
-        // Read entire file content
-        stringstream buffer;
-        buffer << file.rdbuf();
-        string content = buffer.str();
-        file.close();
+        file.seekg(0, ios::end);
+        long long fileSize = (long long)file.tellg();
+        file.seekg(0, ios::beg);
 
-        if (content.empty()) {
+        if (fileSize <= 0) {
             cerr << "Error: File is empty\n";
             return false;
         }
 
         cout << " Loading cities from " << filename << "...\n";
-        cout << "   File size: " << content.length() << " bytes\n";
+        cout << "   File size: " << fileSize << " bytes\n";
+
+        JsonReader reader(file);
 
         // Find the cities array
-        size_t citiesPos = content.find("\"cities\"");
-        if (citiesPos == string::npos) {
+        if (!reader.findTopLevelArray("cities")) {
             cerr << "Error: Could not find 'cities' array in JSON\n";
             return false;
         }
 
-        size_t arrayStart = content.find("[", citiesPos);
-        if (arrayStart == string::npos) {
-            cerr << "Error: Could not find cities array start '['\n";
-            return false;
-        }
-
         cout << "   Found cities array\n";
 
         int cityCount = 0;
-        size_t pos = arrayStart;
-
-        // Find each city object
-        while (true) {
-            size_t objectStart = content.find("{", pos);
-            if (objectStart == string::npos) break;
-
-            size_t objectEnd = content.find("}", objectStart);
-            if (objectEnd == string::npos) break;
-
-            // Check if we're past the cities array
-            size_t arrayEnd = content.find("]", pos);
-            if (arrayEnd != string::npos && objectStart > arrayEnd) break;
+        bool firstCity = true;
+        string key;
+
+        // Parse each city object
+        while (reader.nextElement(firstCity)) {
+            size_t objectStart = reader.offset();
+            if (!reader.consume('{')) {
+                reader.skipValue(); // not an object
+                continue;
+            }
 
-            // Extract city data within this object
             City city;
-            city.code = extractStringValue(content, "code", objectStart);
-            city.name = extractStringValue(content, "name", objectStart);
-            city.airportName = extractStringValue(content, "airport_name", objectStart);
-            city.country = extractStringValue(content, "country", objectStart);
-            city.timezone = extractStringValue(content, "timezone", objectStart);
-            city.latitude = extractNumericValue(content, "latitude", objectStart);
-            city.longitude = extractNumericValue(content, "longitude", objectStart);
+            bool firstKey = true;
+            while (reader.nextKey(key, firstKey)) {
+                bool ok;
+                if (key == "code") ok = reader.readStringField(city.code);
+                else if (key == "name") ok = reader.readStringField(city.name);
+                else if (key == "airport_name") ok = reader.readStringField(city.airportName);
+                else if (key == "country") ok = reader.readStringField(city.country);
+                else if (key == "timezone") ok = reader.readStringField(city.timezone);
+                else if (key == "latitude") ok = reader.readNumberField(city.latitude);
+                else if (key == "longitude") ok = reader.readNumberField(city.longitude);
+                else if (key == "min_connection_minutes") {
+                    double minutes = 0;
+                    ok = reader.readNumberField(minutes);
+                    city.minConnectionMinutes = max(0, (int)minutes);
+                }
+                else ok = reader.skipValue();
+                if (!ok) break;
+            }
+            if (reader.failed()) break;
 
             // Validate essential fields
             if (!city.code.empty() && !city.name.empty()) {
                 cities[city.code] = city;          // store in the graph's city map
+                cityTablesDirty = true;
                 cityCount++;
-                // cout << " Loaded: " << city.code << " - " << city.name << endl; // Commented for cleaner output
             }
             else {
                 cerr << " Warning: Skipped incomplete city at position " << objectStart << endl;
             }
+        }
 
-            pos = objectEnd + 1;
+        if (reader.failed()) {
+            cerr << "Error: Malformed JSON near byte " << reader.offset() << " of " << filename << endl;
+            return false;
         }
 
         cout << "\n Successfully loaded " << cityCount << " cities\n\n";
@@ -387,86 +3066,78 @@ public:
     }
 
 
-    // Load flights from JSON file (unchanged - kept for completeness)
-    bool loadFlightsFromJSON(const string& filename) {
-        // Read entire file into string
-        ifstream file(filename);
+    // Load flights from JSON file (streamed in a single pass).
+    // With threads > 1 the flights array is split and parsed in parallel.
+    bool loadFlightsFromJSON(const string& filename, int threads = 1) {
+        ifstream file(filename, ios::binary);
         if (!file.is_open()) {
             cerr << "Error: Could not open " << filename << endl;
             cerr << " Make sure the file exists in the current directory.\n";
             return false;
         }
 
-        // Read entire file content
-        stringstream buffer;
-        buffer << file.rdbuf();
-        string content = buffer.str();
-        file.close();
+        file.seekg(0, ios::end);
+        long long fileSize = (long long)file.tellg();
+        file.seekg(0, ios::beg);
 
-        if (content.empty()) {
+        if (fileSize <= 0) {
             cerr << "Error: File is empty\n";
             return false;
         }
 
         cout << "Loading flights from " << filename << "...\n";
-        cout << " File size: " << content.length() << " bytes\n";
+        cout << " File size: " << fileSize << " bytes\n";
+
+        JsonReader reader(file);
 
         // Find the flights array
-        size_t flightsPos = content.find("\"flights\"");
-        if (flightsPos == string::npos) {
+        if (!reader.findTopLevelArray("flights")) {
             cerr << "Error: Could not find 'flights' array in JSON\n";
             return false;
         }
 
-        size_t arrayStart = content.find("[", flightsPos);
-        if (arrayStart == string::npos) {
-            cerr << "Error: Could not find flights array start '['\n";
-            return false;
-        }
-
         cout << " Found flights array\n";
 
+        if (threads > 1) {
+            return loadFlightChunks(filename, reader.offset(), (size_t)fileSize, threads);
+        }
+
         int flightCount = 0;
-        size_t pos = arrayStart;
+        bool firstFlight = true;
+        string key;
+
+        // Parse each flight object
+        while (reader.nextElement(firstFlight)) {
+            size_t objectStart = reader.offset();
+            if (!reader.consume('{')) {
+                reader.skipValue(); // not an object
+                continue;
+            }
 
-        // Find each flight object
-        while (true) {
-            size_t objectStart = content.find("{", pos);
-            if (objectStart == string::npos) break;
-            size_t objectEnd = content.find("}", objectStart);
-            if (objectEnd == string::npos) break;
-
-            // Check if we're past the flights array
-            size_t arrayEnd = content.find("]", pos);
-            if (arrayEnd != string::npos && objectStart > arrayEnd) break;
-
-            // Extract flight data within this object
-            string source = extractStringValue(content, "source", objectStart);
-            string destination = extractStringValue(content, "destination", objectStart);
-            string flightNo = extractStringValue(content, "flight_number", objectStart);
-            string airline = extractStringValue(content, "airline", objectStart);
-            string depTime = extractStringValue(content, "departure_time", objectStart);
-            string arrTime = extractStringValue(content, "arrival_time", objectStart);
-            string aircraft = extractStringValue(content, "aircraft", objectStart);
-
-            double duration = extractNumericValue(content, "duration_hours", objectStart);
-            double cost = extractNumericValue(content, "cost_usd", objectStart);
-            int seats = (int)extractNumericValue(content, "seats_available", objectStart);
+            string source;
+            Flight flight;
+            if (!readFlightObject(reader, key, source, flight)) break;
 
             // Validate essential fields
-            if (!source.empty() && !destination.empty() && !flightNo.empty()) {
-                addFlight(source, destination, flightNo, duration, cost, airline,
-                    depTime, arrTime, aircraft, seats);
+            if (!source.empty() && !flight.destination.empty() && !flight.flightNo.empty()) {
+                CityId sourceId = internCity(source);
+                CityId destId = internCity(flight.destination);
+                pendingFlights.push_back({ sourceId, destId, move(flight) });
                 flightCount++;
-                // cout << " Loaded: " << source << " to " << destination << " (" << flightNo << ")" << endl; // Commented for cleaner output
             }
             else {
                 cerr << " Warning: Skipped incomplete flight at position " << objectStart << endl;
             }
+        }
 
-            pos = objectEnd + 1;
+        if (reader.failed()) {
+            cerr << "Error: Malformed JSON near byte " << reader.offset() << " of " << filename << endl;
+            return false;
         }
 
+        // Build the CSR arrays once for the whole file
+        freeze();
+
         if (flightCount > 0) {
             cout << "\n Successfully loaded " << flightCount << " flights\n\n";
             return true;
@@ -477,6 +3148,709 @@ public:
         }
     }
 
+    // Generate a reproducible network in place of cities.json and flights.json,
+    // for benchmarks larger than the sample data. Airports are scattered over
+    // the globe; the first flights link them in a ring so every airport reaches
+    // every other, the rest join random pairs. Durations and fares follow the
+    // great-circle distance.
+    bool generateSyntheticNetwork(size_t airportCount, size_t flightCount, uint64_t seed = SYNTHETIC_SEED) {
+        if (airportCount < 2 || flightCount == 0) {
+            cerr << "Error: A synthetic network needs at least 2 airports and 1 flight\n";
+            return false;
+        }
+        const char* const AIRLINES[] = { "Synthetic Air", "Ring Airways", "Random Wings", "Great Circle Lines" };
+        const char* const AIRCRAFT[] = { "Airbus A320neo", "Boeing 737-800", "Boeing 787-9", "Airbus A350-900" };
+        const char* const FREQUENCIES[] = { "daily", "daily", "3x weekly", "5x weekly" };
+        SyntheticRandom random(seed);
+
+        cout << " Generating " << airportCount << " airports and " << flightCount << " flights...\n";
+
+        int width = max(5, (int)to_string(airportCount - 1).size());
+        vector<string> codes(airportCount);
+        vector<CityId> ids(airportCount);
+        vector<double> latitude(airportCount), longitude(airportCount), cosLatitude(airportCount);
+        for (size_t i = 0; i < airportCount; i++) {
+            string number = to_string(i);
+            codes[i] = "S" + string(width - number.size(), '0') + number;
+
+            City city;
+            city.code = codes[i];
+            city.name = "Synthetic City " + number;
+            city.airportName = "Synthetic Airport " + number;
+            city.country = "Country " + to_string(i % 200);
+            city.latitude = random.between(-60, 70);
+            city.longitude = random.between(-180, 180);
+            int offset = (int)lround(city.longitude / 15);
+            city.timezone = string("GMT (UTC") + (offset < 0 ? "-" : "+") + to_string(abs(offset)) + ")";
+            cities[city.code] = city;
+            ids[i] = internCity(city.code);
+
+            latitude[i] = city.latitude * PI / 180;
+            longitude[i] = city.longitude * PI / 180;
+            cosLatitude[i] = cos(latitude[i]);
+        }
+        cityTablesDirty = true;
+
+        pendingFlights.reserve(pendingFlights.size() + flightCount);
+        for (size_t i = 0; i < flightCount; i++) {
+            size_t from, to;
+            if (i < airportCount) {
+                from = i;
+                to = (i + 1) % airportCount;
+            }
+            else {
+                from = (size_t)random.below(airportCount);
+                to = (size_t)random.below(airportCount - 1);
+                if (to >= from) to++;
+            }
+
+            double km = haversineKm(latitude[from], longitude[from], cosLatitude[from],
+                latitude[to], longitude[to], cosLatitude[to]);
+            int minutes = 30 + (int)lround(km / 800 * 60 * random.between(1, 1.25));
+            double fare = round(50 + km * 0.08 * random.between(0.7, 1.3));
+            int departure = (int)random.below(MINUTES_PER_DAY);
+            int arrival = (departure + minutes) % MINUTES_PER_DAY;
+            char departureTime[8], arrivalTime[8];
+            snprintf(departureTime, sizeof(departureTime), "%02d:%02d", departure / 60, departure % 60);
+            snprintf(arrivalTime, sizeof(arrivalTime), "%02d:%02d", arrival / 60, arrival % 60);
+
+            // Drawn one per statement: argument evaluation order is unspecified
+            const char* airline = AIRLINES[random.below(4)];
+            const char* aircraft = AIRCRAFT[random.below(4)];
+            int seats = (int)random.below(300);
+            const char* frequency = FREQUENCIES[random.below(4)];
+
+            PendingFlight pending;
+            pending.source = ids[from];
+            pending.destination = ids[to];
+            pending.flight = Flight(codes[to], "SY" + to_string(i), minutes / 60.0, fare, airline,
+                departureTime, arrivalTime, aircraft, seats, frequency);
+            pendingFlights.push_back(move(pending));
+        }
+
+        // Build the CSR arrays once for the whole network
+        freeze();
+
+        cout << "\n Successfully generated " << airportCount << " airports and "
+            << flightCount << " flights\n\n";
+        return true;
+    }
+
+    // Parallel part of loadFlightsFromJSON: split the flights array at object
+    // boundaries, parse the pieces on a pool of threads, then merge them in
+    // file order and build the CSR arrays in one step
+    bool loadFlightChunks(const string& filename, size_t arrayStart, size_t fileSize, int threads) {
+        // Several chunks per thread so that uneven chunks still balance out
+        size_t chunkCount = (size_t)threads * 4;
+        size_t span = fileSize - arrayStart;
+
+        vector<FlightChunk> chunks(1);
+        chunks[0].start = arrayStart;
+        {
+            ifstream file(filename, ios::binary);
+            for (size_t k = 1; k < chunkCount; k++) {
+                size_t guess = arrayStart + span / chunkCount * k;
+                if (guess <= chunks.back().start) continue;
+
+                size_t boundary = findElementBoundary(file, guess, fileSize);
+                if (boundary >= fileSize) break;
+
+                chunks.back().end = boundary;
+                chunks.emplace_back();
+                chunks.back().start = boundary;
+            }
+        }
+        chunks.back().end = numeric_limits<size_t>::max();
+
+        cout << " Parsing with " << threads << " threads (" << chunks.size() << " chunks)\n";
+
+        {
+            ThreadPool pool(min((size_t)threads, chunks.size()));
+            pool.parallelFor(chunks.size(), [&](size_t, size_t k) {
+                parseFlightChunk(filename, chunks[k]);
+            });
+        }
+
+        // Each chunk must stop exactly where the next one starts. A split that
+        // landed inside a nested value shows up as a mismatch; in that case the
+        // whole array is parsed again on this thread.
+        size_t usedChunks = chunks.size();
+        for (size_t k = 0; k < chunks.size(); k++) {
+            if (chunks[k].failed || chunks[k].reachedEnd) {
+                usedChunks = k + 1;
+                break;
+            }
+            if (k + 1 == chunks.size() || chunks[k].stopOffset != chunks[k + 1].start) {
+                cerr << " Warning: Chunk boundaries did not line up, parsing serially\n";
+                chunks.assign(1, FlightChunk());
+                chunks[0].start = arrayStart;
+                chunks[0].end = numeric_limits<size_t>::max();
+                parseFlightChunk(filename, chunks[0]);
+                usedChunks = 1;
+                break;
+            }
+        }
+
+        if (chunks[usedChunks - 1].failed) {
+            cerr << "Error: Malformed JSON near byte " << chunks[usedChunks - 1].errorOffset
+                << " of " << filename << endl;
+            return false;
+        }
+
+        // Merge: remap chunk-local city IDs and append in file order
+        size_t totalFlights = 0;
+        for (size_t k = 0; k < usedChunks; k++) {
+            totalFlights += chunks[k].flights.size();
+        }
+        pendingFlights.reserve(pendingFlights.size() + totalFlights);
+
+        for (size_t k = 0; k < usedChunks; k++) {
+            FlightChunk& chunk = chunks[k];
+
+            vector<CityId> globalId(chunk.cityCodes.size());
+            for (size_t i = 0; i < chunk.cityCodes.size(); i++) {
+                globalId[i] = internCity(chunk.cityCodes[i]);
+            }
+
+            for (size_t offset : chunk.skipped) {
+                cerr << " Warning: Skipped incomplete flight at position " << offset << endl;
+            }
+
+            for (PendingFlight& pending : chunk.flights) {
+                pending.source = globalId[pending.source];
+                pending.destination = globalId[pending.destination];
+                pendingFlights.push_back(move(pending));
+            }
+            vector<PendingFlight>().swap(chunk.flights);
+        }
+
+        // Build the CSR arrays once for the whole file
+        freeze();
+
+        if (totalFlights > 0) {
+            cout << "\n Successfully loaded " << totalFlights << " flights\n\n";
+            return true;
+        }
+        else {
+            cerr << "\n No flights were loaded\n";
+            return false;
+        }
+    }
+
+    // Write cities and the frozen graph to a binary snapshot that loadSnapshot() can map
+    bool saveSnapshot(const string& filename) {
+        shared_ptr<const FlatGraph> version = frozen();
+        const FlatGraph& g = *version;
+
+        // String pool; repeated strings (airlines, aircraft, times) are stored once
+        StringPool strings;
+        auto addString = [&](const string& str) { return strings.store(str); };
+
+        // City records, sorted by code for reproducible output
+        vector<string> cityCodeList;
+        for (const auto& pair : cities) {
+            cityCodeList.push_back(pair.first);
+        }
+        sort(cityCodeList.begin(), cityCodeList.end());
+
+        vector<SnapshotCity> cityInfo;
+        for (const string& code : cityCodeList) {
+            const City& city = cities[code];
+            SnapshotCity record;
+            record.code = addString(city.code);
+            record.name = addString(city.name);
+            record.airportName = addString(city.airportName);
+            record.country = addString(city.country);
+            record.timezone = addString(city.timezone);
+            record.latitude = city.latitude;
+            record.longitude = city.longitude;
+            record.minConnectionMinutes = city.minConnectionMinutes;
+            record.reserved = 0;
+            cityInfo.push_back(record);
+        }
+
+        vector<SnapshotString> codes;
+        for (const string& code : g.cityCodes) {
+            codes.push_back(addString(code));
+        }
+
+        vector<SnapshotFlight> flightInfo(g.flightCount());
+        for (uint32_t e = 0; e < g.flightCount(); e++) {
+            flightInfo[e] = packFlight(g.flight(e), strings, true);
+        }
+
+        const string& pool = strings.data;
+        if (pool.size() > numeric_limits<uint32_t>::max()) {
+            cerr << "Error: String pool too large for snapshot format\n";
+            return false;
+        }
+
+        // Lay out the sections
+        SnapshotHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        header.version = SNAPSHOT_VERSION;
+        header.headerSize = sizeof(SnapshotHeader);
+        header.cityInfoCount = (uint32_t)cityInfo.size();
+        header.cityCount = (uint32_t)g.cityCount();
+        header.flightCount = (uint32_t)g.flightCount();
+        header.weightUnits = g.integerWeights ? WEIGHTS_CENTS_MINUTES : WEIGHTS_DOLLARS_HOURS;
+
+        uint64_t offset = sizeof(SnapshotHeader);
+        auto placeSection = [&](uint64_t bytes) {
+            offset = (offset + 7) & ~uint64_t(7);
+            uint64_t start = offset;
+            offset += bytes;
+            return start;
+        };
+        header.cityInfoOffset = placeSection(cityInfo.size() * sizeof(SnapshotCity));
+        header.cityCodeOffset = placeSection(codes.size() * sizeof(SnapshotString));
+        header.firstEdgeOffset = placeSection(g.firstEdge.size() * sizeof(uint32_t));
+        header.edgeDestOffset = placeSection(g.flightCount() * sizeof(CityId));
+        header.edgeCostOffset = placeSection(g.flightCount() * sizeof(double));
+        header.edgeDurationOffset = placeSection(g.flightCount() * sizeof(double));
+        header.flightInfoOffset = placeSection(flightInfo.size() * sizeof(SnapshotFlight));
+        header.stringPoolOffset = placeSection(pool.size());
+        header.stringPoolSize = pool.size();
+        header.fileSize = offset;
+
+        ofstream out(filename, ios::binary | ios::trunc);
+        if (!out.is_open()) {
+            cerr << "Error: Could not create " << filename << endl;
+            return false;
+        }
+
+        uint64_t written = 0;
+        auto writeSection = [&](uint64_t sectionOffset, const void* data, size_t bytes) {
+            static const char padding[8] = { 0 };
+            out.write(padding, (streamsize)(sectionOffset - written));
+            if (bytes > 0) out.write((const char*)data, (streamsize)bytes);
+            written = sectionOffset + bytes;
+        };
+        writeSection(0, &header, sizeof(header));
+        writeSection(header.cityInfoOffset, cityInfo.data(), cityInfo.size() * sizeof(SnapshotCity));
+        writeSection(header.cityCodeOffset, codes.data(), codes.size() * sizeof(SnapshotString));
+        writeSection(header.firstEdgeOffset, g.firstEdge.data, g.firstEdge.size() * sizeof(uint32_t));
+        writeSection(header.edgeDestOffset, g.edgeDest.data, g.flightCount() * sizeof(CityId));
+        writeSection(header.edgeCostOffset, g.edgeCost.data, g.flightCount() * sizeof(double));
+        writeSection(header.edgeDurationOffset, g.edgeDuration.data, g.flightCount() * sizeof(double));
+        writeSection(header.flightInfoOffset, flightInfo.data(), flightInfo.size() * sizeof(SnapshotFlight));
+        writeSection(header.stringPoolOffset, pool.data(), pool.size());
+
+        if (!out) {
+            cerr << "Error: Failed while writing " << filename << endl;
+            return false;
+        }
+
+        cout << " Wrote snapshot " << filename << " (" << header.fileSize << " bytes, "
+            << header.cityInfoCount << " cities, " << header.flightCount << " flights)\n";
+        return true;
+    }
+
+    // Map a binary snapshot written by saveSnapshot(). The CSR arrays are used
+    // in place from the mapping; only city records and codes are copied.
+    bool loadSnapshot(const string& filename) {
+        shared_ptr<MappedFile> file = make_shared<MappedFile>();
+        if (!file->open(filename)) {
+            cerr << "Error: Could not map " << filename << endl;
+            return false;
+        }
+
+        cout << " Mapping snapshot " << filename << "...\n";
+        cout << "   File size: " << file->size() << " bytes\n";
+
+        SnapshotHeader header;
+        if (file->size() < sizeof(header)) {
+            cerr << "Error: File too small to be a snapshot\n";
+            return false;
+        }
+        memcpy(&header, file->data(), sizeof(header));
+
+        if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+            cerr << "Error: Not a flight snapshot file\n";
+            return false;
+        }
+        if (header.version != SNAPSHOT_VERSION || header.headerSize != sizeof(SnapshotHeader)) {
+            cerr << "Error: Snapshot version " << header.version << " is not supported (expected "
+                << SNAPSHOT_VERSION << "), please rebuild it\n";
+            return false;
+        }
+        if (header.fileSize != file->size()) {
+            cerr << "Error: Snapshot is truncated\n";
+            return false;
+        }
+        if (header.weightUnits != WEIGHTS_DOLLARS_HOURS && header.weightUnits != WEIGHTS_CENTS_MINUTES) {
+            cerr << "Error: Snapshot is corrupt\n";
+            return false;
+        }
+
+        // Every section must be aligned and lie inside the file
+        auto sectionOk = [&](uint64_t sectionOffset, uint64_t bytes) {
+            return sectionOffset % 8 == 0 && sectionOffset <= header.fileSize &&
+                bytes <= header.fileSize - sectionOffset;
+        };
+        uint64_t flights = header.flightCount;
+        if (!sectionOk(header.cityInfoOffset, header.cityInfoCount * sizeof(SnapshotCity)) ||
+            !sectionOk(header.cityCodeOffset, header.cityCount * sizeof(SnapshotString)) ||
+            !sectionOk(header.firstEdgeOffset, (header.cityCount + uint64_t(1)) * sizeof(uint32_t)) ||
+            !sectionOk(header.edgeDestOffset, flights * sizeof(CityId)) ||
+            !sectionOk(header.edgeCostOffset, flights * sizeof(double)) ||
+            !sectionOk(header.edgeDurationOffset, flights * sizeof(double)) ||
+            !sectionOk(header.flightInfoOffset, flights * sizeof(SnapshotFlight)) ||
+            !sectionOk(header.stringPoolOffset, header.stringPoolSize)) {
+            cerr << "Error: Snapshot sections are out of bounds\n";
+            return false;
+        }
+
+        const char* base = file->data();
+        const char* pool = base + header.stringPoolOffset;
+        bool stringsOk = true;
+        auto readString = [&](const SnapshotString& str) {
+            if ((uint64_t)str.offset + str.length > header.stringPoolSize) {
+                stringsOk = false;
+                return string();
+            }
+            return string(pool + str.offset, str.length);
+        };
+
+        // City records
+        const SnapshotCity* cityInfo = (const SnapshotCity*)(base + header.cityInfoOffset);
+        unordered_map<string, City> loadedCities;
+        for (uint32_t i = 0; i < header.cityInfoCount; i++) {
+            City city;
+            city.code = readString(cityInfo[i].code);
+            city.name = readString(cityInfo[i].name);
+            city.airportName = readString(cityInfo[i].airportName);
+            city.country = readString(cityInfo[i].country);
+            city.timezone = readString(cityInfo[i].timezone);
+            city.latitude = cityInfo[i].latitude;
+            city.longitude = cityInfo[i].longitude;
+            city.minConnectionMinutes = max(0, (int)cityInfo[i].minConnectionMinutes);
+            loadedCities[city.code] = city;
+        }
+
+        // Interned airport codes, in CityId order
+        const SnapshotString* codes = (const SnapshotString*)(base + header.cityCodeOffset);
+        vector<string> loadedCodes(header.cityCount);
+        unordered_map<string, CityId> loadedIds;
+        for (uint32_t i = 0; i < header.cityCount; i++) {
+            loadedCodes[i] = readString(codes[i]);
+            loadedIds[loadedCodes[i]] = i;
+        }
+
+        // The row offsets must describe exactly flightCount edges, and every
+        // edge must lead to a known city
+        const uint32_t* firstEdge = (const uint32_t*)(base + header.firstEdgeOffset);
+        bool rowsOk = firstEdge[0] == 0 && firstEdge[header.cityCount] == header.flightCount;
+        for (uint32_t u = 0; rowsOk && u < header.cityCount; u++) {
+            rowsOk = firstEdge[u] <= firstEdge[u + 1];
+        }
+        const CityId* edgeDest = (const CityId*)(base + header.edgeDestOffset);
+        for (uint32_t e = 0; rowsOk && e < header.flightCount; e++) {
+            rowsOk = edgeDest[e] < header.cityCount;
+        }
+
+        if (!stringsOk || !rowsOk || loadedIds.size() != loadedCodes.size()) {
+            cerr << "Error: Snapshot is corrupt\n";
+            return false;
+        }
+
+        // Install the mapped graph
+        cities = move(loadedCities);
+        cityCodes = loadedCodes;
+        cityIds = loadedIds;
+        pendingFlights.clear();
+        stagedChanges.clear();
+        cancelledEdges.clear();
+        flightIndex.clear();
+        flightIndexBuilt = false;
+        pendingIndex.clear();
+        pendingIndexed = 0;
+
+        // The columns are mapped as they are, so the snapshot decides the units
+        bool snapshotIntegers = header.weightUnits == WEIGHTS_CENTS_MINUTES;
+        if (snapshotIntegers != integerWeights) {
+            cerr << "Warning: Snapshot stores " << (snapshotIntegers ? "whole cents and minutes" : "dollars and hours")
+                << "; rebuild it" << (snapshotIntegers ? " without" : " with") << " --integer-weights to change that\n";
+        }
+        integerWeights = snapshotIntegers;
+
+        shared_ptr<FlatGraph> next = make_shared<FlatGraph>();
+        next->integerWeights = integerWeights;
+        next->cityCodes = move(loadedCodes);
+        next->cityIds = move(loadedIds);
+        next->firstEdge.attach(base, header.firstEdgeOffset, header.cityCount + 1);
+        next->edgeDest.attach(base, header.edgeDestOffset, header.flightCount);
+        next->edgeCost.attach(base, header.edgeCostOffset, header.flightCount);
+        next->edgeDuration.attach(base, header.edgeDurationOffset, header.flightCount);
+        next->flightInfo = (const SnapshotFlight*)(base + header.flightInfoOffset);
+        next->stringPool = pool;
+        next->stringPoolSize = header.stringPoolSize;
+        next->mapping = file;
+        next->edgeSeats.resize(header.flightCount);
+        for (uint32_t e = 0; e < header.flightCount; e++) {
+            next->edgeSeats[e] = next->flightInfo[e].seatsAvailable;
+        }
+        next->buildReverseIndex();
+        next->buildAirlineIndex();
+        buildGeoBounds(*next);
+        buildTimetable(*next);
+        publish(next);
+
+        cout << "\n Successfully mapped " << header.cityInfoCount << " cities and "
+            << header.flightCount << " flights\n\n";
+        return true;
+    }
+
+    // Pick up to count landmarks and compute their distance tables for the
+    // ALT bounds. The first landmark is the busiest hub; each next one is the
+    // city farthest (by round-trip duration) from all landmarks chosen so far.
+    void buildLandmarks(size_t count) {
+        shared_ptr<const FlatGraph> version = frozen();
+        const FlatGraph& g = *version;
+        LandmarkTables tables;
+
+        size_t n = g.cityCount();
+        if (n == 0 || count == 0) {
+            installLandmarks(g, move(tables));
+            return;
+        }
+
+        // Only cities with flights both in and out can serve as landmarks
+        vector<CityId> candidates;
+        for (CityId u = 0; u < n; u++) {
+            if (g.firstEdge[u + 1] > g.firstEdge[u] && g.firstInEdge[u + 1] > g.firstInEdge[u]) {
+                candidates.push_back(u);
+            }
+        }
+        count = min(count, candidates.size());
+        if (count == 0) {
+            installLandmarks(g, move(tables));
+            return;
+        }
+
+        auto degree = [&](CityId u) { return g.firstEdge[u + 1] - g.firstEdge[u]; };
+        CityId next = *max_element(candidates.begin(), candidates.end(),
+            [&](CityId a, CityId b) { return degree(a) < degree(b); });
+
+        cout << " Selecting " << count << " landmarks...\n";
+
+        auto started = chrono::steady_clock::now();
+        for (vector<double>* table : { &tables.costFrom, &tables.costTo, &tables.durationFrom, &tables.durationTo }) {
+            table->resize(n * count);
+        }
+        vector<double> dist;
+        vector<double> separation(n, INF); // min round-trip duration to any chosen landmark
+        for (size_t i = 0; i < count; i++) {
+            tables.landmarks.push_back(next);
+            fillLandmarkColumn(g, i, count, tables, dist, defaultWorkspace);
+
+            double farthest = -1;
+            for (CityId u : candidates) {
+                double roundTrip = tables.durationFrom[u * count + i] + tables.durationTo[u * count + i];
+                separation[u] = min(separation[u], roundTrip);
+                bool chosen = find(tables.landmarks.begin(), tables.landmarks.end(), u) != tables.landmarks.end();
+                if (!chosen && separation[u] > farthest) {
+                    farthest = separation[u];
+                    next = u;
+                }
+            }
+        }
+
+        preprocessingSeconds += chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+        cout << "   Landmarks:";
+        for (CityId l : tables.landmarks) cout << " " << g.cityCodes[l];
+        cout << "\n";
+        installLandmarks(g, move(tables));
+    }
+
+    // Fill column i (of count) of the city-major tables with the distances
+    // from and to landmark tables.landmarks[i]
+    void fillLandmarkColumn(const FlatGraph& g, size_t i, size_t count, LandmarkTables& tables,
+        vector<double>& dist, SearchWorkspace& ws) const {
+        vector<double>* columns[] = { &tables.costFrom, &tables.costTo, &tables.durationFrom, &tables.durationTo };
+        for (int c = 0; c < 4; c++) {
+            distancesFrom(g, tables.landmarks[i], c < 2, c % 2 == 1, dist, ws);
+            for (size_t v = 0; v < g.cityCount(); v++) {
+                (*columns[c])[v * count + i] = dist[v];
+            }
+        }
+    }
+
+    // Publish a copy of version g with new landmark tables
+    void installLandmarks(const FlatGraph& g, LandmarkTables tables) {
+        shared_ptr<FlatGraph> next = g.clone();
+        landmarkCities = tables.landmarks;
+        if (tables.empty()) next->landmarkTables = nullptr;
+        else next->landmarkTables = make_shared<const LandmarkTables>(move(tables));
+        publish(next);
+    }
+
+    // Write the landmark tables so later runs over the same graph can skip buildLandmarks()
+    bool saveLandmarks(const string& filename) {
+        shared_ptr<const FlatGraph> version = frozen();
+        const FlatGraph& g = *version;
+        if (!g.landmarkTables) {
+            cerr << "Error: No landmark tables to save\n";
+            return false;
+        }
+        const LandmarkTables& tables = *g.landmarkTables;
+
+        LandmarkHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, LANDMARK_MAGIC, sizeof(LANDMARK_MAGIC));
+        header.version = LANDMARK_VERSION;
+        header.landmarkCount = (uint32_t)tables.landmarks.size();
+        header.cityCount = (uint32_t)g.cityCount();
+        header.flightCount = (uint32_t)g.flightCount();
+        header.graphChecksum = g.checksum();
+
+        ofstream out(filename, ios::binary | ios::trunc);
+        if (!out.is_open()) {
+            cerr << "Error: Could not create " << filename << endl;
+            return false;
+        }
+
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)tables.landmarks.data(), tables.landmarks.size() * sizeof(CityId));
+        for (const vector<double>* table : { &tables.costFrom, &tables.costTo, &tables.durationFrom, &tables.durationTo }) {
+            out.write((const char*)table->data(), table->size() * sizeof(double));
+        }
+
+        if (!out) {
+            cerr << "Error: Failed while writing " << filename << endl;
+            return false;
+        }
+        cout << " Wrote " << header.landmarkCount << " landmarks to " << filename << "\n";
+        return true;
+    }
+
+    // Read landmark tables written by saveLandmarks(). Fails (leaving the
+    // current tables untouched) if the file belongs to a different graph.
+    bool loadLandmarks(const string& filename) {
+        shared_ptr<const FlatGraph> version = frozen();
+        const FlatGraph& g = *version;
+
+        ifstream in(filename, ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+
+        LandmarkHeader header;
+        if (!in.read((char*)&header, sizeof(header)) ||
+            memcmp(header.magic, LANDMARK_MAGIC, sizeof(LANDMARK_MAGIC)) != 0 ||
+            header.version != LANDMARK_VERSION) {
+            cerr << " Ignoring " << filename << ": not a landmark file of version " << LANDMARK_VERSION << "\n";
+            return false;
+        }
+        if (header.cityCount != g.cityCount() || header.flightCount != g.flightCount() ||
+            header.graphChecksum != g.checksum() || header.landmarkCount == 0) {
+            cerr << " Ignoring " << filename << ": computed for a different flight network\n";
+            return false;
+        }
+
+        LandmarkTables tables;
+        size_t entries = (size_t)header.cityCount * header.landmarkCount;
+        tables.landmarks.resize(header.landmarkCount);
+        in.read((char*)tables.landmarks.data(), tables.landmarks.size() * sizeof(CityId));
+        for (vector<double>* table : { &tables.costFrom, &tables.costTo, &tables.durationFrom, &tables.durationTo }) {
+            table->resize(entries);
+            in.read((char*)table->data(), entries * sizeof(double));
+        }
+        if (!in) {
+            cerr << " Ignoring " << filename << ": file is truncated\n";
+            return false;
+        }
+        for (CityId l : tables.landmarks) {
+            if (l >= g.cityCount()) {
+                cerr << " Ignoring " << filename << ": landmark out of range\n";
+                return false;
+            }
+        }
+
+        installLandmarks(g, move(tables));
+        cout << " Loaded " << header.landmarkCount << " landmarks from " << filename << "\n";
+        return true;
+    }
+
+    // Load landmark tables from filename, or build count landmarks and save
+    // them there when the file is missing or stale
+    void prepareLandmarks(const string& filename, size_t count) {
+        if (loadLandmarks(filename)) return;
+        buildLandmarks(count);
+        if (currentVersion()->landmarkTables) saveLandmarks(filename);
+    }
+
+    // Preprocess contraction hierarchies for both metrics. Afterwards
+    // findCheapestRoute() and findFastestRoute() answer from the hierarchies
+    // until fares or flights change; refreshPreprocessing() contracts them again.
+    void buildHierarchies() {
+        shared_ptr<const FlatGraph> version = frozen();
+        hierarchiesRequested = true;
+        shared_ptr<ContractionHierarchy> cost = make_shared<ContractionHierarchy>();
+        shared_ptr<ContractionHierarchy> duration = make_shared<ContractionHierarchy>();
+        auto started = chrono::steady_clock::now();
+        cout << " Contracting cost hierarchy...\n";
+        contractHierarchy(*version, true, *cost);
+        cout << " Contracting duration hierarchy...\n";
+        contractHierarchy(*version, false, *duration);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        preprocessingSeconds += seconds;
+        cout << "   Shortcuts: " << cost->shortcutCount() << " (cost), "
+            << duration->shortcutCount() << " (duration) in " << seconds << " s\n";
+        cout << "   Core cities: " << cost->coreSize() << " (cost), " << duration->coreSize() << " (duration)\n";
+
+        shared_ptr<FlatGraph> next = version->clone();
+        next->costHierarchy = cost;
+        next->durationHierarchy = duration;
+        publish(next);
+    }
+
+    // True if updates dropped landmark tables or hierarchies that were built
+    bool preprocessingStale() const {
+        shared_ptr<const FlatGraph> version = currentVersion();
+        return (!landmarkCities.empty() && !version->landmarkTables) ||
+            (hierarchiesRequested && !version->costHierarchy);
+    }
+
+    double preprocessingTime() const { return preprocessingSeconds; }
+
+    // Compute the tables of the same landmarks and contract the hierarchies
+    // again where updates dropped them. Searches answer without them
+    // meanwhile, so callers decide when the rebuild is worth it.
+    void refreshPreprocessing() {
+        shared_ptr<const FlatGraph> version = frozen();
+        if (!preprocessingStale()) return;
+        shared_ptr<FlatGraph> next = version->clone();
+        auto started = chrono::steady_clock::now();
+
+        if (!landmarkCities.empty() && !version->landmarkTables) {
+            LandmarkTables tables;
+            tables.landmarks = landmarkCities;
+            size_t count = landmarkCities.size();
+            for (vector<double>* table : { &tables.costFrom, &tables.costTo, &tables.durationFrom, &tables.durationTo }) {
+                table->resize(version->cityCount() * count);
+            }
+            vector<double> dist;
+            for (size_t i = 0; i < count; i++) {
+                fillLandmarkColumn(*version, i, count, tables, dist, defaultWorkspace);
+            }
+            next->landmarkTables = make_shared<const LandmarkTables>(move(tables));
+        }
+        if (hierarchiesRequested && !version->costHierarchy) {
+            shared_ptr<ContractionHierarchy> cost = make_shared<ContractionHierarchy>();
+            shared_ptr<ContractionHierarchy> duration = make_shared<ContractionHierarchy>();
+            contractHierarchy(*version, true, *cost);
+            contractHierarchy(*version, false, *duration);
+            next->costHierarchy = cost;
+            next->durationHierarchy = duration;
+        }
+
+        preprocessingSeconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        publish(next);
+    }
+
     // Get city name from code (unchanged)
     string getCityName(const string& code) {
         if (cities.find(code) != cities.end()) {
@@ -503,271 +3877,827 @@ public:
         cout << string(50, '-') << "\n\n";
     }
 
-    // Dijkstra's Algorithm - Find cheapest route (unchanged)
+    // Dijkstra's Algorithm - Find cheapest route
     vector<Route> findCheapestRoute(const string& source, const string& dest) {
-        return dijkstra(source, dest, true); // true = optimize by cost
+        freeze();
+        return findCheapestRoute(source, dest, defaultWorkspace);
     }
 
-    // Dijkstra's Algorithm - Find fastest route (unchanged)
+    // Dijkstra's Algorithm - Find fastest route
     vector<Route> findFastestRoute(const string& source, const string& dest) {
-        return dijkstra(source, dest, false); // false = optimize by time
+        freeze();
+        return findFastestRoute(source, dest, defaultWorkspace);
+    }
+
+    // Cheapest, fastest, minimum-stop and Pareto-optimal routes that respect
+    // a party size and airline and transit restrictions
+    vector<Route> findCheapestRoute(const string& source, const string& dest, const RouteFilter& filter) {
+        freeze();
+        return findCheapestRoute(source, dest, filter, defaultWorkspace);
+    }
+
+    vector<Route> findFastestRoute(const string& source, const string& dest, const RouteFilter& filter) {
+        freeze();
+        return findFastestRoute(source, dest, filter, defaultWorkspace);
+    }
+
+    Route findMinimumStops(const string& source, const string& dest, const RouteFilter& filter) {
+        freeze();
+        return findMinimumStops(source, dest, filter, defaultWorkspace);
+    }
+
+    vector<Route> findParetoOptimalRoutes(const string& source, const string& dest, const RouteFilter& filter) {
+        freeze();
+        return findParetoOptimalRoutes(source, dest, filter, defaultWorkspace);
+    }
+
+    // Up to k loopless routes, best first (Yen's algorithm)
+    vector<Route> findAlternativeRoutes(const string& source, const string& dest, bool optimizeByCost,
+        size_t k = DEFAULT_ALTERNATIVES) {
+        freeze();
+        return findAlternativeRoutes(source, dest, optimizeByCost, k, defaultWorkspace);
     }
 
-    // BFS - Find route with minimum stops (unchanged)
+    // BFS - Find route with minimum stops
     Route findMinimumStops(const string& source, const string& dest) {
-        unordered_map<string, int> stops;
-        unordered_map<string, string> parent;
-        unordered_map<string, Flight> parentFlight;
-        queue<string> q;
+        freeze();
+        return findMinimumStops(source, dest, defaultWorkspace);
+    }
+
+    // Multi-objective Dijkstra's to find Pareto-Optimal (non-dominated) routes
+    vector<Route> findParetoOptimalRoutes(const string& source, const string& dest) {
+        freeze();
+        return findParetoOptimalRoutes(source, dest, defaultWorkspace);
+    }
+
+    // Pareto-optimal routes over a combination of CRITERION_* flags
+    vector<Route> findParetoRoutes(const string& source, const string& dest, unsigned criteria) {
+        freeze();
+        return findParetoRoutes(source, dest, criteria, defaultWorkspace);
+    }
+
+    Itinerary findEarliestArrival(const string& source, const string& dest, int departAt) {
+        freeze();
+        return findEarliestArrival(source, dest, departAt, defaultWorkspace);
+    }
+
+    // Convert between a local week minute at an airport and minutes since the
+    // UTC epoch (airports without a known time zone are taken to be on UTC)
+    int localToUtc(const string& code, int localMinute) const {
+        shared_ptr<const FlatGraph> version = currentVersion();
+        CityId u = version->findCity(code);
+        return u == INVALID_CITY ? localMinute : localMinute - version->cityUtcOffset[u];
+    }
+
+    int utcToLocal(const string& code, int utcMinute) const {
+        shared_ptr<const FlatGraph> version = currentVersion();
+        CityId u = version->findCity(code);
+        return u == INVALID_CITY ? utcMinute : utcMinute + version->cityUtcOffset[u];
+    }
+
+    vector<Route> findRoutesFrom(const string& source, bool optimizeByCost) {
+        freeze();
+        return findRoutesFrom(source, optimizeByCost, defaultWorkspace);
+    }
+
+    // Thread-safe search variants. Each pins the current graph version and
+    // runs on it to the end, so any number of threads may call them at once
+    // (each passing its own workspace), also while another thread publishes a
+    // new version with freeze() or a reload. Flights added since the last
+    // freeze() are not visible yet.
+    // Cheapest, fastest and Pareto results are served from the result cache
+    // when possible (ws.settled is then 0)
+    vector<Route> findCheapestRoute(const string& source, const string& dest, SearchWorkspace& ws) const {
+        return findCheapestRoute(source, dest, RouteFilter(), ws);
+    }
+
+    vector<Route> findFastestRoute(const string& source, const string& dest, SearchWorkspace& ws) const {
+        return findFastestRoute(source, dest, RouteFilter(), ws);
+    }
 
-        q.push(source);
-        stops[source] = 0;
+    vector<Route> findParetoOptimalRoutes(const string& source, const string& dest, SearchWorkspace& ws) const {
+        return findParetoOptimalRoutes(source, dest, RouteFilter(), ws);
+    }
+
+    Route findMinimumStops(const string& source, const string& dest, SearchWorkspace& ws) const {
+        return findMinimumStops(source, dest, RouteFilter(), ws);
+    }
+
+    // Restricted variants: only flights the filter allows are taken, and only
+    // through allowed transit airports. Hierarchies and the bidirectional
+    // searches cover every flight, so restricted queries run the
+    // one-directional search; its A* bounds stay admissible since leaving
+    // flights out only makes routes longer.
+    vector<Route> findCheapestRoute(const string& source, const string& dest, const RouteFilter& filter,
+        SearchWorkspace& ws) const {
+        shared_ptr<const FlatGraph> version = currentVersion();
+        const FlatGraph& g = *version;
+        return cachedSearch(g, 'c', source, dest, filter, ws, [&]() {
+            if (!filter.empty()) {
+                SearchFilter restrictions(g, filter);
+                return dijkstra(g, source, dest, true, ws, goalDirectedSearch, &restrictions);
+            }
+            if (g.costHierarchy) return bidirectionalQuery(g, source, dest, hierarchyArcs(*g.costHierarchy), ws);
+            if (bidirectionalSearch) return bidirectionalQuery(g, source, dest, flightArcs(g, true), ws);
+            return dijkstra(g, source, dest, true, ws, goalDirectedSearch); // true = optimize by cost
+        });
+    }
+
+    vector<Route> findFastestRoute(const string& source, const string& dest, const RouteFilter& filter,
+        SearchWorkspace& ws) const {
+        shared_ptr<const FlatGraph> version = currentVersion();
+        const FlatGraph& g = *version;
+        return cachedSearch(g, 'f', source, dest, filter, ws, [&]() {
+            if (!filter.empty()) {
+                SearchFilter restrictions(g, filter);
+                return dijkstra(g, source, dest, false, ws, goalDirectedSearch, &restrictions);
+            }
+            if (g.durationHierarchy) return bidirectionalQuery(g, source, dest, hierarchyArcs(*g.durationHierarchy), ws);
+            if (bidirectionalSearch) return bidirectionalQuery(g, source, dest, flightArcs(g, false), ws);
+            return dijkstra(g, source, dest, false, ws, goalDirectedSearch); // false = optimize by time
+        });
+    }
+
+    vector<Route> findParetoOptimalRoutes(const string& source, const string& dest, const RouteFilter& filter,
+        SearchWorkspace& ws) const {
+        shared_ptr<const FlatGraph> version = currentVersion();
+        const FlatGraph& g = *version;
+        return cachedSearch(g, 'p', source, dest, filter, ws, [&]() {
+            if (filter.empty()) return paretoOptimalRoutes(g, source, dest, nullptr, ws);
+            SearchFilter restrictions(g, filter);
+            return paretoOptimalRoutes(g, source, dest, &restrictions, ws);
+        });
+    }
+
+    // Fewest flights; among those routes the cheapest, then the fastest (the
+    // bidirectional search picks by the same rule)
+    Route findMinimumStops(const string& source, const string& dest, const RouteFilter& filter,
+        SearchWorkspace& ws) const {
+        shared_ptr<const FlatGraph> version = currentVersion();
+        const FlatGraph& g = *version;
+        if (bidirectionalSearch && filter.empty()) return bidirectionalMinimumStops(g, source, dest, ws);
 
-        while (!q.empty()) {
-            string current = q.front();
-            q.pop();
+        unique_ptr<SearchFilter> restrictions;
+        if (!filter.empty()) restrictions.reset(new SearchFilter(g, filter));
+        bool filterFlights = restrictions && restrictions->restrictsFlights;
+        bool filterTransits = restrictions && restrictions->restrictsTransits;
 
-            if (current == dest) break;
+        Route route;
 
-            if (adjList.find(current) == adjList.end()) continue;
+        CityId src = g.findCity(source);
+        CityId dst = g.findCity(dest);
+        if (src == INVALID_CITY || dst == INVALID_CITY) {
+            return route; // Unknown city, no path
+        }
 
-            for (const Flight& flight : adjList[current]) {
-                if (stops.find(flight.destination) == stops.end()) {
-                    stops[flight.destination] = stops[current] + 1;
-                    parent[flight.destination] = current;
-                    parentFlight[flight.destination] = flight;
-                    q.push(flight.destination);
+        ws.begin(g.cityCount());
+        ws.reach(src);
+        ws.hops[src] = 0;
+        ws.distance[src] = 0;
+        ws.secondaryDistance[src] = 0;
+        ws.queue.push_back(src);
+
+        // Level by level: a city's parent is the cheapest (then fastest) of the
+        // cities one level up, all of which are expanded before the city itself.
+        // dest is final once the level above it is done.
+        for (size_t head = 0; head < ws.queue.size(); head++) {
+            CityId current = ws.queue[head];
+            if (ws.reached(dst) && ws.hops[current] >= ws.hops[dst]) break;
+            ws.settled++;
+            if (filterTransits && current != src && !restrictions->allowsTransit(current)) continue;
+
+            for (uint32_t e = g.firstEdge[current]; e < g.firstEdge[current + 1]; e++) {
+                if (filterFlights && !restrictions->allowsFlight(g, e)) continue;
+                CityId next = g.edgeDest[e];
+                if (!ws.reached(next)) {
+                    ws.reach(next);
+                    ws.hops[next] = ws.hops[current] + 1;
+                    ws.queue.push_back(next);
+                }
+                else if (ws.hops[next] != ws.hops[current] + 1) {
+                    continue;
                 }
+
+                double cost = ws.distance[current] + g.edgeCost[e];
+                double duration = ws.secondaryDistance[current] + g.edgeDuration[e];
+                if (!weightLess(cost, duration, ws.distance[next], ws.secondaryDistance[next])) continue;
+                ws.distance[next] = cost;
+                ws.secondaryDistance[next] = duration;
+                ws.parent[next] = current;
+                ws.parentEdge[next] = e;
             }
         }
 
         // Reconstruct path
-        Route route;
-        if (stops.find(dest) == stops.end()) {
+        if (!ws.reached(dst)) {
             return route; // No path found
         }
 
-        vector<string> path;
-        vector<Flight> flightPath;
-        string current = dest;
+        // dest's hop count is the length of its path, so the parent edges are
+        // written back to front straight into the arena
+        PathArena& paths = ws.paths;
+        paths.edges.resize(ws.hops[dst]);
+        size_t slot = paths.edges.size();
+        for (CityId current = dst; current != src; current = ws.parent[current]) {
+            paths.edges[--slot] = ws.parentEdge[current];
+        }
+        paths.close();
+        return buildRoute(g, src, paths.begin(0), paths.end(0));
+    }
+
+    // Multi-objective label-setting search over (cost, duration). Labels are
+    // taken off the queue in lexicographic order, so each one popped is final;
+    // new labels are checked in O(log n) against the Pareto set of their city
+    // and against the routes already found at dest (target pruning).
+    // Cost/duration Pareto search behind findParetoOptimalRoutes(), limited
+    // to what filter allows (null = everything)
+    vector<Route> paretoOptimalRoutes(const FlatGraph& g, const string& source, const string& dest,
+        const SearchFilter* filter, SearchWorkspace& ws) const {
+        vector<Route> optimalRoutes;
 
-        while (current != source) {
-            path.push_back(current);
-            flightPath.push_back(parentFlight[current]);
-            current = parent[current];
+        CityId src = g.findCity(source);
+        CityId dst = g.findCity(dest);
+        if (src == INVALID_CITY || dst == INVALID_CITY || src == dst) {
+            return optimalRoutes; // Unknown city or nowhere to fly, no path
         }
-        path.push_back(source);
 
-        reverse(path.begin(), path.end());
-        reverse(flightPath.begin(), flightPath.end());
+        ws.begin(g.cityCount());
+        vector<Label>& pool = ws.labelPool;
+        vector<vector<uint32_t>>& labels = ws.labels;
+        vector<PQElement>& pq = ws.labelHeap;
+        greater<PQElement> heapOrder;
+        bool filterFlights = filter && filter->restrictsFlights;
+        bool filterTransits = filter && filter->restrictsTransits;
 
-        route.cities = path;
-        route.flights = flightPath;
-        route.stops = flightPath.size()-1;
+        // 1. Initialization
+        ws.reach(src);
+        ws.reach(dst);
+        pool.push_back(Label(0, 0, src, NO_LABEL, NO_EDGE));
+        labels[src].push_back(0);
+        pq.push_back(PQElement(0, 0, 0));
 
-        for (const Flight& f : flightPath) {
-            route.totalCost += f.cost;
-            route.totalDuration += f.duration;
+        // 2. Main Search Loop (Labeling Algorithm)
+        while (!pq.empty()) {
+            pop_heap(pq.begin(), pq.end(), heapOrder);
+            PQElement currentPQ = pq.back();
+            pq.pop_back();
+
+            uint32_t current = currentPQ.label;
+            if (pool[current].dominated) continue; // Replaced by a better label since it was queued
+            CityId currentCity = pool[current].city;
+            ws.settled++;
+
+            if (currentCity == dst) continue; // Extending a route past dest cannot help
+
+            // Target pruning: a route already found at dest is at least as good
+            if (paretoCovered(pool, labels[dst], currentPQ.cost, currentPQ.duration)) continue;
+            if (filterTransits && currentCity != src && !filter->allowsTransit(currentCity)) continue;
+
+            // 3. Relaxation and Dominance Check
+            for (uint32_t e = g.firstEdge[currentCity]; e < g.firstEdge[currentCity + 1]; e++) {
+                if (filterFlights && !filter->allowsFlight(g, e)) continue;
+                CityId nextCity = g.edgeDest[e];
+                double cost = currentPQ.cost + g.edgeCost[e];
+                double duration = currentPQ.duration + g.edgeDuration[e];
+
+                ws.reach(nextCity);
+                if (paretoCovered(pool, labels[nextCity], cost, duration)) continue;
+                if (nextCity != dst && paretoCovered(pool, labels[dst], cost, duration)) continue;
+
+                uint32_t next = (uint32_t)pool.size();
+                pool.push_back(Label(cost, duration, nextCity, current, e));
+                paretoInsert(pool, labels[nextCity], next);
+                pq.push_back(PQElement(next, cost, duration));
+                push_heap(pq.begin(), pq.end(), heapOrder);
+            }
         }
 
-        return route;
+        // 4. Reconstruct all Pareto-Optimal Routes to Destination by following
+        // parent indices; the set is already sorted by cost for clean display
+        for (uint32_t l : labels[dst]) ws.paths.addLabelPath(pool, l, NO_LABEL);
+        buildRoutes(g, src, ws.paths, optimalRoutes);
+
+        return optimalRoutes;
     }
 
-    // Multi-objective Dijkstra's to find Pareto-Optimal (non-dominated) routes
-    vector<Route> findParetoOptimalRoutes(const string& source, const string& dest) {
-        // Map to store the set of non-dominated labels (Cost, Duration) found so far for each city
-        unordered_map<string, vector<Label>> labels;
+    // Generalized Pareto search over any combination of the CRITERION_* flags
+    // (cost, duration, hops and layover time). Same label-setting scheme as
+    // findParetoOptimalRoutes(), with each city's front split into buckets
+    // by hop count so dominance checks only scan labels that could dominate.
+    vector<Route> findParetoRoutes(const string& source, const string& dest, unsigned criteria,
+        SearchWorkspace& ws) const {
+        shared_ptr<const FlatGraph> version = currentVersion();
+        const FlatGraph& g = *version;
+        vector<Route> optimalRoutes;
+
+        CityId src = g.findCity(source);
+        CityId dst = g.findCity(dest);
+        if (src == INVALID_CITY || dst == INVALID_CITY || src == dst) {
+            return optimalRoutes; // Unknown city or nowhere to fly, no path
+        }
 
-        // Use a priority queue guided by a heuristic (e.g., sum of cost and duration)
-        priority_queue<PQElement, vector<PQElement>, greater<PQElement>> pq;
+        ws.begin(g.cityCount());
+        vector<CriteriaLabel>& pool = ws.criteriaPool;
+        vector<CriteriaQueueEntry>& pq = ws.criteriaHeap;
+        greater<CriteriaQueueEntry> heapOrder;
+        bool useLayover = (criteria & CRITERION_LAYOVER) != 0;
+
+        // Bucket key for a label landing at u at the given week minute; at
+        // dest every label is comparable since no further layover follows
+        auto arrivalKey = [&](CityId u, int arrival) -> int {
+            if (!useLayover || u == dst || arrival == NO_TIME) return -1;
+            return arrival;
+        };
+
+        // True if a label at u with the given arrival key is at least as good as value
+        auto covered = [&](CityId u, const double* value, int arrival) {
+            int hops = (int)value[2];
+            for (uint32_t b = 0; b < ws.criteriaBucketCount[u]; b++) {
+                const CriteriaBucket& bucket = ws.criteriaBuckets[u][b];
+                if (bucket.hops > hops || bucket.arrival != arrival) continue;
+                if (bucket.covers(value[0], value[1], value[3])) return true;
+            }
+            return false;
+        };
+
+        // Add pool[index] to its city's front, dropping the labels it dominates
+        auto insert = [&](uint32_t index) {
+            const CriteriaLabel& label = pool[index];
+            CityId u = label.city;
+            int hops = (int)label.value[2];
+            int arrival = arrivalKey(u, label.arrival);
+
+            vector<CriteriaBucket>& buckets = ws.criteriaBuckets[u];
+            uint32_t& count = ws.criteriaBucketCount[u];
+            CriteriaBucket* home = nullptr;
+            for (uint32_t b = 0; b < count; b++) {
+                CriteriaBucket& bucket = buckets[b];
+                if (bucket.hops < hops || bucket.arrival != arrival) continue;
+                bucket.removeCovered(pool, label.value[0], label.value[1], label.value[3]);
+                if (bucket.hops == hops) home = &bucket;
+            }
+            if (!home) {
+                if (count == buckets.size()) buckets.emplace_back();
+                home = &buckets[count++];
+                home->reset(hops, arrival);
+            }
+            home->add(label, index);
+        };
 
         // 1. Initialization
-        Label initialLabel;
-        initialLabel.cost = 0;
-        initialLabel.duration = 0;
-        initialLabel.parentCity = source;
-        // parentFlight is intentionally empty for the source node
-
-        labels[source].push_back(initialLabel);
-        pq.push(PQElement(source, 0, 0));
+        ws.reach(src);
+        ws.reach(dst);
+        CriteriaLabel initial = { { 0, 0, 0, 0 }, src, NO_LABEL, NO_EDGE, NO_TIME, false };
+        pool.push_back(initial);
+        insert(0);
+        pq.push_back({ 0, { 0, 0, 0, 0 } });
 
         // 2. Main Search Loop (Labeling Algorithm)
         while (!pq.empty()) {
-            PQElement currentPQ = pq.top();
-            pq.pop();
-            string currentCity = currentPQ.city;
-
-            if (adjList.find(currentCity) == adjList.end()) continue;
-
-            // Iterate over all labels found for the current city
-            for (const Label& currentLabel : labels[currentCity]) {
-                // IMPORTANT: We only process the label if its cost/duration matches the one we extracted
-                // from the PQ (this handles stale entries, though not perfectly in a multi-label map)
-                if (abs(currentLabel.cost - currentPQ.cost) > 0.001 ||
-                    abs(currentLabel.duration - currentPQ.duration) > 0.001) {
-                    // This label may be a duplicate or dominated, skip for simplicity.
-                    // This is a simplification; a full correctness check requires a more complex PQ setup.
+            pop_heap(pq.begin(), pq.end(), heapOrder);
+            CriteriaQueueEntry current = pq.back();
+            pq.pop_back();
+
+            const CriteriaLabel& currentLabel = pool[current.label];
+            if (currentLabel.dominated) continue; // Replaced by a better label since it was queued
+            CityId currentCity = currentLabel.city;
+            ws.settled++;
+
+            if (currentCity == dst) continue; // Extending a route past dest cannot help
+
+            // Target pruning: a route already found at dest is at least as good
+            if (covered(dst, current.value, -1)) continue;
+
+            int arrivedAt = currentLabel.arrival;
+
+            // 3. Relaxation and Dominance Check
+            auto relax = [&](const CriteriaLabel& next) {
+                ws.reach(next.city);
+                if (covered(next.city, next.value, arrivalKey(next.city, next.arrival))) return;
+                if (next.city != dst && covered(dst, next.value, -1)) return;
+
+                uint32_t index = (uint32_t)pool.size();
+                pool.push_back(next);
+                insert(index);
+
+                CriteriaQueueEntry entry;
+                entry.label = index;
+                memcpy(entry.value, next.value, sizeof(entry.value));
+                pq.push_back(entry);
+                push_heap(pq.begin(), pq.end(), heapOrder);
+            };
+            for (uint32_t e = g.firstEdge[currentCity]; e < g.firstEdge[currentCity + 1]; e++) {
+                CriteriaLabel next;
+                memcpy(next.value, current.value, sizeof(next.value));
+                if (criteria & CRITERION_COST) next.value[0] += g.edgeCost[e];
+                if (criteria & CRITERION_DURATION) next.value[1] += g.edgeDuration[e];
+                if (criteria & CRITERION_HOPS) next.value[2] += 1;
+                next.city = g.edgeDest[e];
+                next.parent = current.label;
+                next.parentEdge = e;
+                next.arrival = NO_TIME;
+                next.dominated = false;
+
+                int departure = g.edgeDepartureUtc[e];
+                if (!useLayover || departure == NO_TIME) {
+                    relax(next);
+                    continue;
+                }
+
+                // Layovers come from the weekly timetable: after landing, wait
+                // at least the city's minimum connection time, then for the
+                // next day this flight operates
+                int travel = g.edgeArrivalUtc[e] - departure;
+                if (arrivedAt != NO_TIME) {
+                    int ready = arrivedAt + g.minConnectionMinutes[currentCity];
+                    int layover = g.minConnectionMinutes[currentCity] + g.waitForDeparture(e, ready);
+                    next.value[3] += g.integerWeights ? layover : layover / 60.0; // duration units
+                    next.arrival = wrapMinutes(arrivedAt + layover + travel, MINUTES_PER_WEEK);
+                    relax(next);
                     continue;
                 }
 
-                // 3. Relaxation and Dominance Check
-                for (const Flight& flight : adjList[currentCity]) {
-                    string nextCity = flight.destination;
+                // No arrival time to connect from (the source, or after an
+                // unscheduled flight): each operating day starts a route of its own
+                for (int day = 0; day < 7; day++) {
+                    if (!(g.edgeOperatingDays[e] & (1 << day))) continue;
+                    next.arrival = wrapMinutes(departure + day * MINUTES_PER_DAY + travel, MINUTES_PER_WEEK);
+                    relax(next);
+                }
+            }
+        }
 
-                    Label newLabel;
-                    newLabel.cost = currentLabel.cost + flight.cost;
-                    newLabel.duration = currentLabel.duration + flight.duration;
-                    newLabel.parentCity = currentCity;
-                    newLabel.parentFlight = flight;
+        // 4. Reconstruct the routes at dest, best first in criteria order
+        vector<uint32_t> front;
+        for (uint32_t b = 0; b < ws.criteriaBucketCount[dst]; b++) {
+            const CriteriaBucket& bucket = ws.criteriaBuckets[dst][b];
+            front.insert(front.end(), bucket.label.begin(), bucket.label.end());
+        }
+        sort(front.begin(), front.end(), [&](uint32_t a, uint32_t b) {
+            return lexicographical_compare(pool[a].value, pool[a].value + MAX_CRITERIA,
+                pool[b].value, pool[b].value + MAX_CRITERIA);
+        });
 
-                    bool isDominated = false;
-                    auto& nextLabels = labels[nextCity];
+        for (uint32_t l : front) ws.paths.addLabelPath(pool, l, NO_LABEL);
+        buildRoutes(g, src, ws.paths, optimalRoutes);
 
-                    // Check if newLabel is dominated by an existing label in the destination city
-                    for (const Label& existingLabel : nextLabels) {
-                        if (newLabel.isDominatedBy(existingLabel)) {
-                            isDominated = true;
-                            break;
-                        }
-                    }
+        return optimalRoutes;
+    }
 
-                    if (isDominated) continue; // Skip dominated path
+    // One-to-all: the cheapest (or fastest) route from source to every other
+    // reachable city, in CityId order, all taken from a single search tree.
+    // Where several routes tie, one of them is returned.
+    vector<Route> findRoutesFrom(const string& source, bool optimizeByCost, SearchWorkspace& ws) const {
+        shared_ptr<const FlatGraph> version = currentVersion();
+        const FlatGraph& g = *version;
+        vector<Route> routes;
+
+        CityId src = g.findCity(source);
+        if (src == INVALID_CITY) return routes;
+
+        searchFromSource(g, src, optimizeByCost, ws);
+        vector<uint32_t> edges;
+        for (CityId v = 0; v < g.cityCount(); v++) {
+            if (v == src || !ws.reached(v) || ws.distance[v] >= INF) continue;
+
+            edges.clear();
+            for (CityId city = v; city != src; city = g.edgeSource[ws.parentEdge[city]]) {
+                edges.push_back(ws.parentEdge[city]);
+            }
+            reverse(edges.begin(), edges.end());
+            routes.push_back(buildRoute(g, src, edges));
+        }
+        return routes;
+    }
 
-                    // Check if newLabel dominates any existing labels
-                    // We must use a separate loop to safely remove dominated labels
-                    vector<Label> dominatedLabels;
-                    for (const Label& existingLabel : nextLabels) {
-                        if (newLabel.dominates(existingLabel)) {
-                            dominatedLabels.push_back(existingLabel);
-                        }
-                    }
+    // Up to k loopless routes from source to dest, best first by cost (or
+    // duration) with ties broken by the other metric, using Yen's algorithm.
+    // Each route returned is deviated from at every city from the point where
+    // it left the route it came from (Lawler's refinement). The spur search
+    // there avoids the route's earlier cities and the next flights of the
+    // routes already returned with the same prefix. One reverse search from
+    // dest gives all spur searches an exact A* bound, which also skips spurs
+    // that cannot beat the k-th candidate already waiting. Routes share their
+    // prefixes in ws.pathTree. A query that runs past the latency budget
+    // returns the routes found so far (still the best ones, in order), and
+    // ws.settled counts the cities settled by all its spur searches.
+    vector<Route> findAlternativeRoutes(const string& source, const string& dest, bool optimizeByCost,
+        size_t k, SearchWorkspace& ws) const {
+        shared_ptr<const FlatGraph> version = currentVersion();
+        const FlatGraph& g = *version;
+        vector<Route> routes;
+
+        CityId src = g.findCity(source);
+        CityId dst = g.findCity(dest);
+        if (src == INVALID_CITY || dst == INVALID_CITY || src == dst || k == 0) return routes;
+
+        auto deadline = chrono::steady_clock::now() + alternativesBudget;
+        ws.begin(g.cityCount());
+        distancesFrom(g, dst, optimizeByCost, true, ws.targetDistance, ws);
+        if (ws.targetDistance[src] >= INF) return routes;
+
+        vector<PathNode>& tree = ws.pathTree;
+        tree.clear();
+        tree.push_back({ src, NO_EDGE, NO_NODE, NO_NODE, NO_NODE, 0, 0, 0, false, false });
+
+        auto primary = [&](uint32_t n) { return optimizeByCost ? tree[n].cost : tree[n].duration; };
+        auto secondary = [&](uint32_t n) { return optimizeByCost ? tree[n].duration : tree[n].cost; };
+        auto better = [&](uint32_t a, uint32_t b) {
+            if (abs(primary(a) - primary(b)) >= EPSILON) return primary(a) < primary(b);
+            if (abs(secondary(a) - secondary(b)) >= EPSILON) return secondary(a) < secondary(b);
+            return tree[a].depth < tree[b].depth;
+        };
+
+        // Waiting routes as (last node, depth where they deviate), best first and
+        // never more than the number of routes still wanted
+        vector<pair<uint32_t, uint32_t>> candidates;
+        vector<uint32_t> path, blockedEdges;
+        size_t settled = 0;
+
+        uint32_t first = spurSearch(g, 0, dst, optimizeByCost, blockedEdges, INF, ws);
+        settled += ws.settled;
+        if (first != NO_NODE) {
+            tree[first].queued = true;
+            candidates.push_back({ first, 0 });
+        }
 
-                    // Remove dominated labels
-                    for (const Label& dominatedLabel : dominatedLabels) {
-                        auto it = std::remove_if(nextLabels.begin(), nextLabels.end(),
-                            [&](const Label& l) { return l.cost == dominatedLabel.cost && l.duration == dominatedLabel.duration; });
-                        nextLabels.erase(it, nextLabels.end());
-                    }
+        bool outOfTime = false;
+        while (routes.size() < k && !candidates.empty() && !outOfTime) {
+            uint32_t tail = candidates.front().first;
+            uint32_t deviation = candidates.front().second;
+            candidates.erase(candidates.begin());
+            tree[tail].queued = false;
+
+            path.clear();
+            for (uint32_t n = tail; n != NO_NODE; n = tree[n].parent) path.push_back(n);
+            reverse(path.begin(), path.end());
+
+            vector<uint32_t>& edges = ws.spurEdges;
+            edges.clear();
+            for (size_t i = 1; i < path.size(); i++) {
+                tree[path[i]].accepted = true;
+                edges.push_back(tree[path[i]].edge);
+            }
+            routes.push_back(buildRoute(g, src, edges));
+            if (routes.size() == k) break;
+            size_t wanted = k - routes.size();
+
+            // Spur from every city of the new route past its deviation point
+            for (size_t i = 0; i < deviation; i++) ws.blockedCity[tree[path[i]].city] = 1;
+            for (size_t i = deviation; i + 1 < path.size(); i++) {
+                if (chrono::steady_clock::now() > deadline) {
+                    outOfTime = true;
+                    break;
+                }
 
-                    // Add new non-dominated label
-                    bool isDuplicate = false;
-                    for (const Label& existingLabel : nextLabels) {
-                        if (existingLabel.cost == newLabel.cost && existingLabel.duration == newLabel.duration) {
-                            isDuplicate = true;
-                            break;
-                        }
+                uint32_t spur = path[i];
+                CityId city = tree[spur].city;
+                double bound = candidates.size() >= wanted ? primary(candidates[wanted - 1].first) : INF;
+                if (primary(spur) + ws.targetDistance[city] <= bound + EPSILON) {
+                    blockedEdges.clear();
+                    for (uint32_t c = tree[spur].firstChild; c != NO_NODE; c = tree[c].nextSibling) {
+                        if (tree[c].accepted) blockedEdges.push_back(tree[c].edge);
                     }
 
-                    if (!isDuplicate) {
-                        nextLabels.push_back(newLabel);
-                        pq.push(PQElement(nextCity, newLabel.cost, newLabel.duration));
+                    uint32_t found = spurSearch(g, spur, dst, optimizeByCost, blockedEdges, bound, ws);
+                    settled += ws.settled;
+                    if (found != NO_NODE && !tree[found].queued && !tree[found].accepted) {
+                        auto at = upper_bound(candidates.begin(), candidates.end(), found,
+                            [&](uint32_t n, const pair<uint32_t, uint32_t>& c) { return better(n, c.first); });
+                        candidates.insert(at, { found, (uint32_t)i });
+                        tree[found].queued = true;
+                        if (candidates.size() > wanted) {
+                            tree[candidates.back().first].queued = false;
+                            candidates.pop_back();
+                        }
                     }
                 }
+                ws.blockedCity[city] = 1;
             }
+            for (uint32_t n : path) ws.blockedCity[tree[n].city] = 0;
         }
 
-        // 4. Reconstruct all Pareto-Optimal Routes to Destination
-        vector<Route> optimalRoutes;
-        if (labels.find(dest) == labels.end()) {
-            return optimalRoutes; // No path found
-        }
-
-        for (const Label& finalLabel : labels[dest]) {
-            Route route;
-            route.totalCost = finalLabel.cost;
-            route.totalDuration = finalLabel.duration;
-
-            string currentCity = dest;
-            Label currentLabel = finalLabel;
-
-            // Reconstruct path backwards from the final label
-            vector<string> path;
-            vector<Flight> flightPath;
-
-            // Loop until we reach the source
-            while (currentCity != source) {
-                path.push_back(currentCity);
-
-                // Add the flight that arrived at currentCity
-                flightPath.push_back(currentLabel.parentFlight);
+        ws.settled = settled;
+        return routes;
+    }
 
-                // Find the previous city
-                string parentCityCode = currentLabel.parentCity;
+    // Write the cost and duration matrices between origins and destinations
+    // (airport codes) to filename in the route matrix format. Each origin needs
+    // one one-to-all search, which stops early once every destination is
+    // settled; origins are spread over threads and written in row blocks, so
+    // memory stays bounded for large matrices.
+    bool buildRouteMatrix(const string& filename, const vector<string>& origins,
+        const vector<string>& destinations, bool optimizeByCost, int threads) {
+        shared_ptr<const FlatGraph> version = frozen();
+        const FlatGraph& g = *version;
+        const size_t ROW_BLOCK = 256;
+
+        vector<CityId> originIds, destinationIds;
+        for (int side = 0; side < 2; side++) {
+            const vector<string>& codes = side == 0 ? origins : destinations;
+            vector<CityId>& ids = side == 0 ? originIds : destinationIds;
+            for (const string& code : codes) {
+                CityId id = g.findCity(code);
+                if (id == INVALID_CITY) {
+                    cerr << "Error: Unknown airport " << code << " in route matrix\n";
+                    return false;
+                }
+                ids.push_back(id);
+            }
+        }
 
-                // If we are at the source, stop
-                if (parentCityCode == source) break;
+        string codeBlock;
+        for (const string& code : origins) codeBlock.append(code.c_str(), code.size() + 1);
+        for (const string& code : destinations) codeBlock.append(code.c_str(), code.size() + 1);
+
+        size_t rowSize = destinationIds.size();
+        uint64_t matrixBytes = (uint64_t)originIds.size() * rowSize * sizeof(float);
+
+        MatrixHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, MATRIX_MAGIC, sizeof(MATRIX_MAGIC));
+        header.version = MATRIX_VERSION;
+        header.optimizeByCost = optimizeByCost ? 1 : 0;
+        header.originCount = (uint32_t)originIds.size();
+        header.destinationCount = (uint32_t)destinationIds.size();
+        header.graphChecksum = g.checksum();
+        header.codeBytes = codeBlock.size();
+        header.costOffset = (sizeof(MatrixHeader) + codeBlock.size() + 7) & ~uint64_t(7);
+        header.durationOffset = header.costOffset + ((matrixBytes + 7) & ~uint64_t(7));
+
+        ofstream out(filename, ios::binary | ios::trunc);
+        if (!out.is_open()) {
+            cerr << "Error: Could not create " << filename << endl;
+            return false;
+        }
+        out.write((const char*)&header, sizeof(header));
+        out.write(codeBlock.data(), (streamsize)codeBlock.size());
 
-                // Calculate the parent label's cost/duration
-                double parentCost = currentLabel.cost - currentLabel.parentFlight.cost;
-                double parentDuration = currentLabel.duration - currentLabel.parentFlight.duration;
+        // Column of each destination city (several columns may share a city)
+        vector<vector<uint32_t>> columns(g.cityCount());
+        for (size_t j = 0; j < rowSize; j++) {
+            columns[destinationIds[j]].push_back((uint32_t)j);
+        }
+        vector<char> isTarget(g.cityCount(), 0);
+        size_t targetCount = 0;
+        for (CityId v : destinationIds) {
+            if (!isTarget[v]) targetCount++;
+            isTarget[v] = 1;
+        }
 
-                // Search the parent city's labels for the one that matches
-                bool foundParent = false;
-                if (labels.count(parentCityCode)) {
-                    for (const Label& parentLabel : labels[parentCityCode]) {
-                        // Check for near-exact match (accounting for floating point errors)
-                        if (abs(parentLabel.cost - parentCost) < 0.001 && abs(parentLabel.duration - parentDuration) < 0.001) {
-                            currentCity = parentCityCode;
-                            currentLabel = parentLabel;
-                            foundParent = true;
-                            break;
-                        }
+        unique_ptr<ThreadPool> pool;
+        if (threads > 1) pool.reset(new ThreadPool((size_t)threads));
+        vector<SearchWorkspace> workspaces(pool ? pool->size() : 1);
+
+        vector<float> costRows, durationRows;
+        for (size_t first = 0; first < originIds.size(); first += ROW_BLOCK) {
+            size_t rows = min(ROW_BLOCK, originIds.size() - first);
+            costRows.assign(rows * rowSize, numeric_limits<float>::infinity());
+            durationRows.assign(rows * rowSize, numeric_limits<float>::infinity());
+
+            auto fillRow = [&](size_t worker, size_t r) {
+                SearchWorkspace& ws = workspaces[worker];
+                CityId src = originIds[first + r];
+                searchFromSource(g, src, optimizeByCost, ws, &isTarget, targetCount);
+
+                float* costRow = &costRows[r * rowSize];
+                float* durationRow = &durationRows[r * rowSize];
+                for (CityId v : destinationIds) {
+                    if (!ws.reached(v) || ws.distance[v] >= INF || columns[v].empty()) continue;
+                    double cost = g.costValue(optimizeByCost ? ws.distance[v] : ws.secondaryDistance[v]);
+                    double duration = g.durationValue(optimizeByCost ? ws.secondaryDistance[v] : ws.distance[v]);
+                    for (uint32_t j : columns[v]) {
+                        costRow[j] = (float)cost;
+                        durationRow[j] = (float)duration;
                     }
                 }
-
-                if (!foundParent) {
-                    // Fallback for safety - should not happen if logic is perfect
-                    path.clear();
-                    flightPath.clear();
-                    break;
-                }
+            };
+            if (pool) {
+                pool->parallelFor(rows, fillRow);
+            }
+            else {
+                for (size_t r = 0; r < rows; r++) fillRow(0, r);
             }
 
-            if (!path.empty()) {
-                path.push_back(source);
-                reverse(path.begin(), path.end());
-                reverse(flightPath.begin(), flightPath.end());
+            uint64_t rowOffset = (uint64_t)first * rowSize * sizeof(float);
+            out.seekp((streamoff)(header.costOffset + rowOffset));
+            out.write((const char*)costRows.data(), (streamsize)(costRows.size() * sizeof(float)));
+            out.seekp((streamoff)(header.durationOffset + rowOffset));
+            out.write((const char*)durationRows.data(), (streamsize)(durationRows.size() * sizeof(float)));
+        }
 
-                route.cities = path;
-                route.flights = flightPath;
-                route.stops = flightPath.size(); // stops is flight count - 1 if layovers, but since it's just path length...
-                route.stops = flightPath.empty() ? 0 : flightPath.size() - 1;
+        // The last row block ends the file; a matrix without rows still needs
+        // the alignment gap before its (empty) sections
+        uint64_t fileSize = header.durationOffset + matrixBytes;
+        uint64_t written = (uint64_t)out.tellp();
+        if (written < fileSize) out.write(string(fileSize - written, '\0').data(), (streamsize)(fileSize - written));
+        out.flush();
+        if (!out || (uint64_t)out.tellp() != fileSize) {
+            cerr << "Error: Failed while writing " << filename << endl;
+            return false;
+        }
+        return true;
+    }
 
-                optimalRoutes.push_back(route);
+    // Connection Scan Algorithm: the earliest arrival at dest when leaving
+    // source at departAt (minutes since the UTC epoch) or later. Connections are
+    // scanned in departure order starting at departAt and wrapping into the
+    // next week, so itineraries may start up to a week after departAt. A
+    // connection can be taken if its origin is reached at least that city's
+    // minimum connection time before it departs (no minimum at the source).
+    // ws.settled counts the connections scanned.
+    Itinerary findEarliestArrival(const string& source, const string& dest, int departAt, SearchWorkspace& ws) const {
+        shared_ptr<const FlatGraph> version = currentVersion();
+        const FlatGraph& g = *version;
+        Itinerary itinerary;
+        ws.begin(g.cityCount());
+
+        CityId src = g.findCity(source);
+        CityId dst = g.findCity(dest);
+        if (src == INVALID_CITY || dst == INVALID_CITY || src == dst) return itinerary;
+
+        const vector<Connection>& connections = *g.connections;
+        size_t count = connections.size();
+        if (count == 0) return itinerary;
+
+        int weekStart = departAt - wrapMinutes(departAt, MINUTES_PER_WEEK);
+        size_t first = lower_bound(connections.begin(), connections.end(), departAt - weekStart,
+            [](const Connection& c, int minute) { return c.departure < minute; }) - connections.begin();
+
+        ws.reach(src);
+        ws.reach(dst);
+        ws.arrivalTime[src] = departAt;
+
+        for (size_t k = first; k < first + count; k++) {
+            const Connection& c = connections[k % count];
+            int offset = weekStart + (k >= count ? MINUTES_PER_WEEK : 0);
+            int departure = c.departure + offset;
+
+            // Everything after this departs too late to beat the best arrival
+            if (departure >= ws.arrivalTime[dst]) break;
+            ws.settled++;
+
+            if (!ws.reached(c.from) || ws.arrivalTime[c.from] == NO_TIME) continue;
+            int ready = ws.arrivalTime[c.from] + (c.from == src ? 0 : g.minConnectionMinutes[c.from]);
+            if (ready > departure) continue;
+
+            ws.reach(c.to);
+            int arrival = c.arrival + offset;
+            if (arrival < ws.arrivalTime[c.to]) {
+                ws.arrivalTime[c.to] = arrival;
+                ws.arrivalConnection[c.to] = (uint32_t)k;
             }
         }
 
-        // Sort the optimal routes by cost for clean display
-        sort(optimalRoutes.begin(), optimalRoutes.end(), [](const Route& a, const Route& b) {
-            if (a.totalCost != b.totalCost) return a.totalCost < b.totalCost;
-            return a.totalDuration < b.totalDuration;
-            });
+        if (ws.arrivalTime[dst] == NO_TIME) return itinerary;
 
-        return optimalRoutes;
+        // Walk the arriving connections back to the source
+        vector<uint32_t> legs;
+        for (CityId v = dst; v != src; v = connections[legs.back() % count].from) {
+            if (legs.size() >= g.cityCount()) return itinerary; // cannot happen with non-negative durations
+            legs.push_back(ws.arrivalConnection[v]);
+        }
+        reverse(legs.begin(), legs.end());
+
+        vector<uint32_t> edges;
+        for (uint32_t k : legs) {
+            const Connection& c = connections[k % count];
+            int offset = weekStart + (k >= count ? MINUTES_PER_WEEK : 0);
+            edges.push_back(c.edge);
+            itinerary.departures.push_back(c.departure + offset);
+            itinerary.arrivals.push_back(c.arrival + offset);
+        }
+        itinerary.route = buildRoute(g, src, edges);
+        return itinerary;
     }
 
-    void displayGraph() const {
+    void displayGraph() {
+        shared_ptr<const FlatGraph> version = frozen();
+        const FlatGraph& g = *version;
+
         cout << "\n--- ENTIRE FLIGHT GRAPH (ADJACENCY LIST) ---\n";
         cout << "Format: SOURCE -> [Flight_Number] DESTINATION (Duration, Cost, Departure, Arrival)\n\n";
 
-        // Collect all source city codes (keys in adjList)
-        vector<string> sortedCities;
-        for (const auto& pair : adjList) {
-            sortedCities.push_back(pair.first);
+        // Collect all cities with outbound flights
+        vector<CityId> sortedCities;
+        for (CityId u = 0; u < g.cityCount(); u++) {
+            if (g.firstEdge[u] != g.firstEdge[u + 1]) {
+                sortedCities.push_back(u);
+            }
         }
 
-        // Sort the keys (source cities) for clean, reproducible output
-        sort(sortedCities.begin(), sortedCities.end());
-
-        for (const string& sourceCity : sortedCities) {
-            // Retrieve the list of outbound flights
-            const vector<Flight>& outboundFlights = adjList.at(sourceCity);
+        // Sort the source cities by code for clean, reproducible output
+        sort(sortedCities.begin(), sortedCities.end(), [&](CityId a, CityId b) {
+            return g.cityCodes[a] < g.cityCodes[b];
+            });
 
+        for (CityId sourceCity : sortedCities) {
             // Print the source city header
-            cout << "\n" << sourceCity << " (" << outboundFlights.size() << " outbound flights):\n";
+            cout << "\n" << g.cityCodes[sourceCity] << " (" << g.firstEdge[sourceCity + 1] - g.firstEdge[sourceCity] << " outbound flights):\n";
 
             // Print all outbound flights from this city
-            for (const Flight& flight : outboundFlights) {
+            for (uint32_t e = g.firstEdge[sourceCity]; e < g.firstEdge[sourceCity + 1]; e++) {
+                Flight flight = g.flight(e);
                 cout << "  - ["
                     << flight.flightNo << "] " // Using flightNo
                     << flight.destination
@@ -864,7 +4794,7 @@ public:
     }
 
     //Display multiple routes
-    void displayParetoRoutes(const vector<Route>& routes) {
+    void displayParetoRoutes(const vector<Route>& routes, const string& criteria = "Cost and Duration") {
         if (routes.empty()) {
             cout << "\nNo Pareto-Optimal routes found!\n\n";
             return;
@@ -872,7 +4802,7 @@ public:
 
         cout << "\n" << string(70, '=') << "\n";
         cout << " PARETO-OPTIMAL ROUTE OPTIONS (Non-Dominated)\n";
-        cout << " (Best compromises between Cost and Duration)\n";
+        cout << " (Best compromises between " << criteria << ")\n";
         cout << string(70, '=') << "\n";
 
         // Display summary table
@@ -904,132 +4834,1101 @@ public:
         }
     }
 
-    // Display graph statistics (unchanged)
+    // Ranked alternatives (best first) as a table, then one of them in full
+    void displayAlternativeRoutes(const vector<Route>& routes, const string& title) {
+        if (routes.empty()) {
+            cout << "\nNo routes found for " << title << ".\n";
+            return;
+        }
+
+        cout << "\n" << string(70, '=') << "\n";
+        cout << " TOP " << routes.size() << " " << title << " ROUTES\n";
+        cout << string(70, '=') << "\n";
+
+        cout << left << setw(8) << "RANK"
+            << setw(15) << "TOTAL COST"
+            << setw(20) << "TOTAL DURATION"
+            << setw(10) << "STOPS" << "\n";
+        cout << string(70, '-') << "\n";
+
+        for (size_t i = 0; i < routes.size(); i++) {
+            cout << left << setw(8) << to_string(i + 1) + "."
+                << "$" << setw(14) << fixed << setprecision(2) << routes[i].totalCost
+                << setw(17) << to_string(routes[i].totalDuration) + " hours"
+                << setw(10) << routes[i].stops << "\n";
+        }
+        cout << string(70, '=') << "\n";
+
+        cout << "\nEnter rank for full details, or 0 to return to menu: ";
+        size_t choice;
+        if (!(cin >> choice)) {
+            cin.clear();
+            return;
+        }
+        if (choice > 0 && choice <= routes.size()) {
+            displayRoute(routes[choice - 1], title + " ALTERNATIVE (Rank " + to_string(choice) + ")");
+        }
+        else if (choice != 0) {
+            cout << "Invalid option.\n";
+        }
+    }
+
+    // Show an itinerary in the local time of each airport (departAt is UTC)
+    void displayItinerary(const Itinerary& itinerary, int departAt) {
+        const Route& route = itinerary.route;
+        if (route.cities.empty()) {
+            cout << "\nNo scheduled connection found within a week!\n\n";
+            return;
+        }
+
+        int journey = itinerary.arrivals.back() - departAt;
+
+        cout << "\n" << string(70, '-') << "\n";
+        cout << "  EARLIEST ARRIVAL (TIMETABLE)\n";
+        cout << string(70, '-') << "\n";
+        cout << "Departing after: " << formatWeekMinute(utcToLocal(route.cities.front(), departAt))
+            << " (local)\n";
+        cout << "Arrival: " << formatWeekMinute(utcToLocal(route.cities.back(), itinerary.arrivals.back()))
+            << " (local)\n";
+        cout << "Journey Time: " << journey / 60 << "h " << journey % 60 << "m (including waits)\n";
+        cout << "Total Cost: $" << fixed << setprecision(2) << route.totalCost << "\n";
+        cout << "Number of Stops: " << route.stops << "\n";
+        cout << string(70, '-') << "\n\n";
+
+        for (size_t i = 0; i < route.flights.size(); i++) {
+            const Flight& f = route.flights[i];
+
+            cout << "Flight " << (i + 1) << ": " << f.flightNo << "\n";
+            cout << "   " << getCityName(route.cities[i]) << " -> "
+                << getCityName(f.destination) << "\n";
+            cout << "   Airline: " << f.airline << "\n";
+            cout << "   Departs: " << formatWeekMinute(utcToLocal(route.cities[i], itinerary.departures[i]))
+                << " | Arrives: " << formatWeekMinute(utcToLocal(f.destination, itinerary.arrivals[i]))
+                << " (local)\n";
+            cout << "   Duration: " << f.duration << "h | Cost: $"
+                << fixed << setprecision(2) << f.cost << "\n";
+
+            if (i < route.flights.size() - 1) {
+                int wait = itinerary.departures[i + 1] - itinerary.arrivals[i];
+                cout << "\n   Connection at " << getCityName(f.destination) << ": "
+                    << wait / 60 << "h " << wait % 60 << "m\n\n";
+            }
+        }
+
+        cout << string(70, '-') << "\n\n";
+    }
+
+    // Display graph statistics
     void displayStats() {
+        shared_ptr<const FlatGraph> version = frozen();
+        const FlatGraph& g = *version;
+
         cout << "\nNETWORK STATISTICS\n";
         cout << string(40, '-') << "\n";
         cout << "Total Cities: " << cities.size() << "\n";
 
-        int totalFlights = 0;
-        for (const auto& pair : adjList) {
-            totalFlights += pair.second.size();
+        // Cities with at least one outbound flight
+        vector<pair<string, int>> cityConnections;
+        for (CityId u = 0; u < g.cityCount(); u++) {
+            int outbound = g.firstEdge[u + 1] - g.firstEdge[u];
+            if (outbound > 0) {
+                cityConnections.push_back({ g.cityCodes[u], outbound });
+            }
         }
+
+        int totalFlights = (int)g.flightCount();
         cout << "Total Flights: " << totalFlights << "\n";
         cout << "Average Routes per City: "
-            << (adjList.empty() ? 0 : totalFlights / adjList.size()) << "\n";
+            << (cityConnections.empty() ? 0 : totalFlights / cityConnections.size()) << "\n";
 
         // Find hub cities (most connections)
-        vector<pair<string, int>> cityConnections;
-        for (const auto& pair : adjList) {
-            cityConnections.push_back({ pair.first, pair.second.size() });
+        stable_sort(cityConnections.begin(), cityConnections.end(),
+            [](const pair<string, int>& a, const pair<string, int>& b) {
+                return a.second > b.second;
+            });
+
+        cout << "\nTop Hub Cities:\n";
+        for (size_t i = 0; i < min(size_t(5), cityConnections.size()); i++) {
+            cout << "   " << (i + 1) << ". "
+                << getCityName(cityConnections[i].first)
+                << " - " << cityConnections[i].second << " outbound flights\n";
+        }
+
+        if (resultCache.enabled()) {
+            size_t entries, bytes;
+            resultCache.usage(entries, bytes);
+            uint64_t hits = resultCache.hitCount();
+            uint64_t lookups = hits + resultCache.missCount();
+            cout << "\nResult Cache: " << entries << " results cached (" << bytes / 1024 << " KB), "
+                << hits << " hits / " << lookups << " lookups";
+            if (lookups > 0) cout << " (" << fixed << setprecision(1) << 100.0 * hits / lookups << "%)";
+            cout << ", " << resultCache.evictionCount() << " evictions\n";
+        }
+        cout << "\n";
+    }
+
+    // Bytes held by each part of the current graph version (vector capacity;
+    // mapped parts are the size of their snapshot section) and the resident
+    // set of the process, as reported by /proc
+    void displayMemoryReport() {
+        shared_ptr<const FlatGraph> version = frozen();
+        const FlatGraph& g = *version;
+        size_t m = g.flightCount();
+
+        size_t hot = g.firstEdge.size() * sizeof(uint32_t) + m * (sizeof(CityId) + 2 * sizeof(double)) +
+            vectorBytes(g.edgeSeats) + vectorBytes(g.edgeAirline);
+        size_t cold = m * sizeof(SnapshotFlight) + g.stringPoolSize;
+        size_t reverse = vectorBytes(g.firstInEdge) + vectorBytes(g.inEdges) + vectorBytes(g.edgeSource);
+        size_t schedule = vectorBytes(g.edgeDepartureUtc) + vectorBytes(g.edgeArrivalUtc) +
+            vectorBytes(g.edgeOperatingDays) + (g.connections ? vectorBytes(*g.connections) : 0);
+        size_t preprocessing = 0;
+        if (g.landmarkTables) {
+            const LandmarkTables& tables = *g.landmarkTables;
+            preprocessing += vectorBytes(tables.landmarks) + vectorBytes(tables.costFrom) +
+                vectorBytes(tables.costTo) + vectorBytes(tables.durationFrom) + vectorBytes(tables.durationTo);
+        }
+        for (const ContractionHierarchy* ch : { g.costHierarchy.get(), g.durationHierarchy.get() }) {
+            if (!ch) continue;
+            preprocessing += vectorBytes(ch->rank) + vectorBytes(ch->arcSource) + vectorBytes(ch->arcTarget) +
+                vectorBytes(ch->arcPrimary) + vectorBytes(ch->arcSecondary) + vectorBytes(ch->arcMiddle) +
+                vectorBytes(ch->firstTiedMiddle) + vectorBytes(ch->tiedMiddles) + vectorBytes(ch->firstUpArc) +
+                vectorBytes(ch->upArcs) + vectorBytes(ch->firstDownArc) + vectorBytes(ch->downArcs);
+        }
+        size_t total = hot + cold + reverse + schedule + preprocessing;
+
+        cout << "\nMEMORY REPORT (" << g.cityCount() << " cities, " << m << " flights"
+            << (g.isMapped() ? ", mapped snapshot" : "") << ")\n";
+        cout << string(60, '-') << "\n";
+        cout << left << setw(34) << "PART" << setw(14) << "MB" << "BYTES/FLIGHT\n";
+        auto row = [&](const string& name, size_t bytes) {
+            cout << left << setw(34) << name << setw(14) << fixed << setprecision(1) << bytes / 1048576.0
+                << setprecision(1) << (m > 0 ? (double)bytes / m : 0.0) << "\n";
+        };
+        row("Hot edge columns", hot);
+        row("Cold flight metadata", cold);
+        row("Reverse index", reverse);
+        row("Schedule and timetable", schedule);
+        row("Landmarks and hierarchies", preprocessing);
+        row("Total", total);
+        cout << string(60, '-') << "\n";
+
+        ifstream status("/proc/self/status");
+        string line;
+        while (getline(status, line)) {
+            if (line.compare(0, 6, "VmRSS:") == 0 || line.compare(0, 6, "VmHWM:") == 0) {
+                cout << (line[2] == 'R' ? "Resident set: " : "Peak resident set: ")
+                    << line.substr(line.find_first_not_of(" \t", 6)) << "\n";
+            }
+        }
+    }
+
+    // List available cities (unchanged)
+    void listCities() {
+        cout << "\nAVAILABLE CITIES\n";
+        cout << string(70, '-') << "\n";
+
+        vector<pair<string, string>> cityList;
+        for (const auto& pair : cities) {
+            cityList.push_back({ pair.first, pair.second.name });
+        }
+        sort(cityList.begin(), cityList.end());
+
+        for (const auto& city : cityList) {
+            cout << left << setw(6) << city.first << " - " << city.second << "\n";
+        }
+        cout << "\nTotal: " << cityList.size() << " cities\n\n";
+    }
+
+private:
+    // Run search on the workspace queue chosen with setSearchQueue()
+    template <typename Search>
+    auto withSearchQueue(SearchWorkspace& ws, Search search) const -> decltype(search(ws.quadQueue)) {
+        switch (searchQueue) {
+        case QUEUE_BINARY: return search(ws.binaryQueue);
+        case QUEUE_RADIX: return search(ws.radixQueue);
+        default: return search(ws.quadQueue);
+        }
+    }
+
+    // Answer from the result cache, or run search and remember its result
+    template <typename Search>
+    vector<Route> cachedSearch(const FlatGraph& g, char objective, const string& source, const string& dest,
+        const RouteFilter& filter, SearchWorkspace& ws, Search search) const {
+        if (!resultCache.enabled()) return search();
+
+        string key = RouteCache::makeKey(objective, source, dest, filter.cacheKey());
+        shared_ptr<const vector<Route>> cached = resultCache.lookup(key, g.version);
+        if (cached) {
+            ws.settled = 0;
+            return *cached; // copied outside the shard lock
+        }
+
+        shared_ptr<const vector<Route>> routes = make_shared<const vector<Route>>(search());
+        resultCache.store(key, routes, g.version);
+        return *routes;
+    }
+
+    // One-to-all Dijkstra from src. Afterwards every reached city holds its
+    // best primary and secondary totals in ws.distance and ws.secondaryDistance
+    // (ties on the primary metric broken by the secondary one, as in
+    // dijkstra()) and the last flight of that route in ws.parentEdge. With
+    // isTarget given, the search stops once targetCount marked cities are settled.
+    void searchFromSource(const FlatGraph& g, CityId src, bool optimizeByCost, SearchWorkspace& ws,
+        const vector<char>* isTarget = nullptr, size_t targetCount = 0) const {
+        withSearchQueue(ws, [&](auto& pq) {
+            searchFromSource(g, src, optimizeByCost, ws, pq, isTarget, targetCount);
+        });
+    }
+
+    template <typename Queue>
+    void searchFromSource(const FlatGraph& g, CityId src, bool optimizeByCost, SearchWorkspace& ws,
+        Queue& pq, const vector<char>* isTarget, size_t targetCount) const {
+        const Column<double>& primaryWeight = optimizeByCost ? g.edgeCost : g.edgeDuration;
+        const Column<double>& secondaryWeight = optimizeByCost ? g.edgeDuration : g.edgeCost;
+
+        ws.begin(g.cityCount());
+        pq.reset(g.cityCount());
+        vector<double>& distance = ws.distance;
+        vector<double>& secondaryDistance = ws.secondaryDistance;
+
+        ws.reach(src);
+        distance[src] = 0;
+        secondaryDistance[src] = 0;
+        pq.push(src, 0);
+
+        while (!pq.empty()) {
+            CityId u = pq.pop();
+            ws.settled++;
+
+            if (isTarget && (*isTarget)[u] && --targetCount == 0) break;
+
+            for (uint32_t e = g.firstEdge[u]; e < g.firstEdge[u + 1]; e++) {
+                CityId v = g.edgeDest[e];
+                ws.reach(v);
+
+                double primary = distance[u] + primaryWeight[e];
+                double secondary = secondaryDistance[u] + secondaryWeight[e];
+                bool better = primary < distance[v] - EPSILON ||
+                    (abs(primary - distance[v]) < EPSILON && secondary < secondaryDistance[v] - EPSILON);
+                if (!better) continue;
+
+                distance[v] = primary;
+                secondaryDistance[v] = secondary;
+                ws.parentEdge[v] = e;
+                pq.push(v, primary);
+            }
+        }
+    }
+
+    // Spur search of findAlternativeRoutes(): the best route from the city of
+    // tree node spur to dst that avoids the cities marked in ws.blockedCity
+    // and, leaving that city, the flights in blockedEdges. A* on the exact
+    // distances to dst in ws.targetDistance; nothing whose primary total
+    // (prefix up to spur included) exceeds bound is searched. The route is
+    // added below spur in ws.pathTree and its last node returned (NO_NODE if
+    // there is none).
+    uint32_t spurSearch(const FlatGraph& g, uint32_t spur, CityId dst, bool optimizeByCost,
+        const vector<uint32_t>& blockedEdges, double bound, SearchWorkspace& ws) const {
+        return withSearchQueue(ws, [&](auto& pq) {
+            return spurSearch(g, spur, dst, optimizeByCost, blockedEdges, bound, ws, pq);
+        });
+    }
+
+    template <typename Queue>
+    uint32_t spurSearch(const FlatGraph& g, uint32_t spur, CityId dst, bool optimizeByCost,
+        const vector<uint32_t>& blockedEdges, double bound, SearchWorkspace& ws, Queue& pq) const {
+        const Column<double>& primaryWeight = optimizeByCost ? g.edgeCost : g.edgeDuration;
+        const Column<double>& secondaryWeight = optimizeByCost ? g.edgeDuration : g.edgeCost;
+        vector<PathNode>& tree = ws.pathTree;
+        CityId start = tree[spur].city;
+        double prefix = optimizeByCost ? tree[spur].cost : tree[spur].duration;
+
+        ws.begin(g.cityCount());
+        pq.reset(g.cityCount());
+        vector<double>& distance = ws.distance;
+        vector<double>& secondaryDistance = ws.secondaryDistance;
+
+        ws.reach(dst);
+        ws.reach(start);
+        distance[start] = 0;
+        secondaryDistance[start] = 0;
+        pq.push(start, ws.targetDistance[start]);
+
+        while (!pq.empty()) {
+            // Keep going while routes tied with the best one so far may remain
+            double priority = pq.minKey();
+            if (priority > distance[dst] + EPSILON || prefix + priority > bound + EPSILON) break;
+
+            CityId u = pq.pop();
+            ws.settled++;
+            if (u == dst) continue;
+
+            for (uint32_t e = g.firstEdge[u]; e < g.firstEdge[u + 1]; e++) {
+                if (u == start && find(blockedEdges.begin(), blockedEdges.end(), e) != blockedEdges.end()) continue;
+                CityId v = g.edgeDest[e];
+                if (ws.blockedCity[v] || ws.targetDistance[v] >= INF) continue;
+                ws.reach(v);
+
+                double primary = distance[u] + primaryWeight[e];
+                double secondary = secondaryDistance[u] + secondaryWeight[e];
+                bool better = primary < distance[v] - EPSILON ||
+                    (abs(primary - distance[v]) < EPSILON && secondary < secondaryDistance[v] - EPSILON);
+                if (!better) continue;
+
+                distance[v] = primary;
+                secondaryDistance[v] = secondary;
+                ws.parentEdge[v] = e;
+                pq.push(v, primary + ws.targetDistance[v]);
+            }
+        }
+        if (distance[dst] >= INF) return NO_NODE;
+
+        vector<uint32_t>& edges = ws.spurEdges;
+        edges.clear();
+        for (CityId city = dst; city != start; city = g.edgeSource[ws.parentEdge[city]]) {
+            edges.push_back(ws.parentEdge[city]);
+        }
+
+        // Walk down the tree from spur, adding the nodes this route is the first to use
+        uint32_t node = spur;
+        for (size_t i = edges.size(); i-- > 0;) {
+            uint32_t e = edges[i];
+            uint32_t child = tree[node].firstChild;
+            while (child != NO_NODE && tree[child].edge != e) child = tree[child].nextSibling;
+            if (child == NO_NODE) {
+                child = (uint32_t)tree.size();
+                PathNode next = { g.edgeDest[e], e, node, NO_NODE, tree[node].firstChild, tree[node].depth + 1,
+                    tree[node].cost + g.edgeCost[e], tree[node].duration + g.edgeDuration[e], false, false };
+                tree.push_back(next);
+                tree[node].firstChild = child;
+            }
+            node = child;
+        }
+        return node;
+    }
+
+    // One-to-all Dijkstra from origin by cost or duration on the workspace
+    // queue. With reverse set it follows flights backwards, so dist[v] is the
+    // distance from v to origin. dist may be a vector of ws.
+    void distancesFrom(const FlatGraph& g, CityId origin, bool byCost, bool reverse, vector<double>& dist,
+        SearchWorkspace& ws) const {
+        withSearchQueue(ws, [&](auto& pq) {
+            distancesFrom(g, origin, byCost, reverse, dist, pq);
+        });
+    }
+
+    template <typename Queue>
+    void distancesFrom(const FlatGraph& g, CityId origin, bool byCost, bool reverse, vector<double>& dist,
+        Queue& pq) const {
+        const Column<double>& weight = byCost ? g.edgeCost : g.edgeDuration;
+        dist.assign(g.cityCount(), INF);
+        pq.reset(g.cityCount());
+        dist[origin] = 0;
+        pq.push(origin, 0);
+
+        while (!pq.empty()) {
+            CityId u = pq.pop();
+
+            uint32_t begin = reverse ? g.firstInEdge[u] : g.firstEdge[u];
+            uint32_t end = reverse ? g.firstInEdge[u + 1] : g.firstEdge[u + 1];
+            for (uint32_t i = begin; i < end; i++) {
+                uint32_t e = reverse ? g.inEdges[i] : i;
+                CityId v = reverse ? g.edgeSource[e] : g.edgeDest[e];
+                double candidate = dist[u] + weight[e];
+                if (candidate < dist[v]) {
+                    dist[v] = candidate;
+                    pq.push(v, candidate);
+                }
+            }
+        }
+    }
+
+    // Contract the cities of the frozen graph in order of importance, adding a
+    // shortcut u -> w for a path u -> v -> w whenever no other path avoiding v
+    // is strictly better. Each pair keeps one shortcut, the best by (primary,
+    // secondary): a detour that only ties the existing u -> w arc is recorded
+    // as a tied middle, and one that beats it replaces it. Importance is the
+    // edge difference (arcs added minus arcs removed) plus the number of
+    // already contracted neighbours, recomputed lazily when a city reaches the
+    // front of the queue. The last CORE_CITY_FRACTION of the cities form the core.
+    void contractHierarchy(const FlatGraph& g, bool byCost, ContractionHierarchy& ch) const {
+        const Column<double>& primaryWeight = byCost ? g.edgeCost : g.edgeDuration;
+        const Column<double>& secondaryWeight = byCost ? g.edgeDuration : g.edgeCost;
+        size_t n = g.cityCount();
+        size_t m = g.flightCount();
+
+        ch = ContractionHierarchy();
+        ch.rank.assign(n, 0);
+        for (uint32_t e = 0; e < m; e++) {
+            ch.addArc(g.edgeSource[e], g.edgeDest[e], primaryWeight[e], secondaryWeight[e], INVALID_CITY);
+        }
+
+        // Remaining graph: arcs between uncontracted cities. Flights beaten
+        // by a parallel flight and self-loops can never be on an optimal route.
+        vector<vector<uint32_t>> outArcs(n), inArcs(n);
+        vector<uint32_t> bestArc(n, NO_EDGE);
+        for (CityId u = 0; u < n; u++) {
+            for (uint32_t e = g.firstEdge[u]; e < g.firstEdge[u + 1]; e++) {
+                CityId v = g.edgeDest[e];
+                if (v == u) continue;
+                if (bestArc[v] == NO_EDGE ||
+                    weightLess(ch.arcPrimary[e], ch.arcSecondary[e], ch.arcPrimary[bestArc[v]], ch.arcSecondary[bestArc[v]])) {
+                    bestArc[v] = e;
+                }
+            }
+            for (uint32_t e = g.firstEdge[u]; e < g.firstEdge[u + 1]; e++) {
+                CityId v = g.edgeDest[e];
+                if (v == u) continue;
+                uint32_t best = bestArc[v];
+                if (weightTied(ch.arcPrimary[e], ch.arcSecondary[e], ch.arcPrimary[best], ch.arcSecondary[best])) {
+                    outArcs[u].push_back(e);
+                    inArcs[v].push_back(e);
+                }
+            }
+            for (uint32_t e = g.firstEdge[u]; e < g.firstEdge[u + 1]; e++) {
+                bestArc[g.edgeDest[e]] = NO_EDGE;
+            }
+        }
+        vector<char> inHierarchy(m, 0); // arcs replaced by a better shortcut drop out
+        for (CityId u = 0; u < n; u++) {
+            for (uint32_t e : outArcs[u]) inHierarchy[e] = 1;
+        }
+        vector<vector<CityId>> arcTies(m);
+
+        size_t coreCities = max((size_t)1, (size_t)(n * CORE_CITY_FRACTION));
+        vector<char> contracted(n, 0);
+        vector<int> contractedNeighbours(n, 0);
+
+        // Witness search state (generation stamped like SearchWorkspace)
+        const size_t WITNESS_SETTLE_LIMIT = 200;
+        vector<uint32_t> witnessStamp(n, 0);
+        vector<uint32_t> witnessDone(n, 0); // settled stamp
+        uint32_t witnessGeneration = 0;
+        vector<double> witnessPrimary(n), witnessSecondary(n);
+        vector<PQNode> witnessHeap;
+        greater<PQNode> heapOrder;
+
+        // Best path through v to each target, and the existing direct arc, per source
+        vector<double> viaPrimary(n, INF), viaSecondary(n, INF);
+        vector<uint32_t> directArc(n, NO_EDGE);
+        vector<CityId> targets;
+
+        auto unlink = [&](uint32_t a) {
+            vector<uint32_t>& out = outArcs[ch.arcSource[a]];
+            out.erase(remove(out.begin(), out.end(), a), out.end());
+            vector<uint32_t>& in = inArcs[ch.arcTarget[a]];
+            in.erase(remove(in.begin(), in.end(), a), in.end());
+        };
+
+        // Arcs contracting v adds to the remaining graph, or (apply) contract it for real
+        auto contract = [&](CityId v, bool apply) -> size_t {
+            vector<uint32_t> incoming = inArcs[v];
+            sort(incoming.begin(), incoming.end(), [&](uint32_t a, uint32_t b) {
+                return ch.arcSource[a] < ch.arcSource[b];
+            });
+            size_t added = 0;
+
+            for (size_t begin = 0; begin < incoming.size();) {
+                CityId u = ch.arcSource[incoming[begin]];
+                size_t end = begin;
+                while (end < incoming.size() && ch.arcSource[incoming[end]] == u) end++;
+
+                // Best u -> v -> w for each target w
+                targets.clear();
+                double longest = 0;
+                for (size_t i = begin; i < end; i++) {
+                    uint32_t a = incoming[i];
+                    for (uint32_t b : outArcs[v]) {
+                        CityId w = ch.arcTarget[b];
+                        if (w == u) continue;
+                        double primary = ch.arcPrimary[a] + ch.arcPrimary[b];
+                        double secondary = ch.arcSecondary[a] + ch.arcSecondary[b];
+                        if (viaPrimary[w] == INF) targets.push_back(w);
+                        if (viaPrimary[w] == INF || weightLess(primary, secondary, viaPrimary[w], viaSecondary[w])) {
+                            viaPrimary[w] = primary;
+                            viaSecondary[w] = secondary;
+                        }
+                        longest = max(longest, viaPrimary[w]);
+                    }
+                }
+
+                if (!targets.empty()) {
+                    for (uint32_t a : outArcs[u]) directArc[ch.arcTarget[a]] = a;
+
+                    // Witness search from u that avoids v and stops past the longest candidate
+                    if (++witnessGeneration == 0) {
+                        fill(witnessStamp.begin(), witnessStamp.end(), 0);
+                        fill(witnessDone.begin(), witnessDone.end(), 0);
+                        witnessGeneration = 1;
+                    }
+                    witnessStamp[u] = witnessGeneration;
+                    witnessPrimary[u] = 0;
+                    witnessSecondary[u] = 0;
+                    witnessHeap.clear();
+                    witnessHeap.push_back({ u, 0, 0, 0 });
+                    size_t witnessSettled = 0;
+                    size_t targetsLeft = targets.size();
+                    while (!witnessHeap.empty() && witnessSettled < WITNESS_SETTLE_LIMIT && targetsLeft > 0) {
+                        pop_heap(witnessHeap.begin(), witnessHeap.end(), heapOrder);
+                        PQNode current = witnessHeap.back();
+                        witnessHeap.pop_back();
+                        CityId x = current.city;
+                        if (current.cost > witnessPrimary[x] || current.duration > witnessSecondary[x]) continue;
+                        if (current.cost > longest + EPSILON) break;
+                        if (witnessDone[x] == witnessGeneration) continue;
+                        witnessDone[x] = witnessGeneration;
+                        witnessSettled++;
+                        if (viaPrimary[x] < INF) targetsLeft--;
+
+                        for (uint32_t c : outArcs[x]) {
+                            CityId y = ch.arcTarget[c];
+                            if (y == v) continue;
+                            double primary = current.cost + ch.arcPrimary[c];
+                            double secondary = current.duration + ch.arcSecondary[c];
+                            if (witnessStamp[y] != witnessGeneration ||
+                                primary < witnessPrimary[y] ||
+                                (primary == witnessPrimary[y] && secondary < witnessSecondary[y])) {
+                                witnessStamp[y] = witnessGeneration;
+                                witnessPrimary[y] = primary;
+                                witnessSecondary[y] = secondary;
+                                witnessHeap.push_back({ y, primary, secondary, primary });
+                                push_heap(witnessHeap.begin(), witnessHeap.end(), heapOrder);
+                            }
+                        }
+                    }
+
+                    // One shortcut per target unless a witness beats it or the direct arc ties it
+                    for (CityId w : targets) {
+                        double primary = viaPrimary[w];
+                        double secondary = viaSecondary[w];
+                        viaPrimary[w] = INF;
+                        if (witnessStamp[w] == witnessGeneration &&
+                            weightLess(witnessPrimary[w], witnessSecondary[w], primary, secondary)) {
+                            continue;
+                        }
+                        uint32_t direct = directArc[w];
+                        if (direct != NO_EDGE && !weightLess(primary, secondary, ch.arcPrimary[direct], ch.arcSecondary[direct])) {
+                            if (apply) arcTies[direct].push_back(v);
+                            continue;
+                        }
+                        if (direct != NO_EDGE && ch.arcMiddle[direct] != INVALID_CITY) {
+                            // Improve the existing shortcut in place
+                            if (apply) {
+                                ch.arcPrimary[direct] = primary;
+                                ch.arcSecondary[direct] = secondary;
+                                ch.arcMiddle[direct] = v;
+                                arcTies[direct].clear();
+                            }
+                            continue;
+                        }
+                        if (direct == NO_EDGE) added++;
+                        if (!apply) continue;
+                        // Flights u -> w (parallel ones tie) are all beaten by the detour
+                        if (direct != NO_EDGE) {
+                            vector<uint32_t> beaten;
+                            for (uint32_t a : outArcs[u]) {
+                                if (ch.arcTarget[a] == w) beaten.push_back(a);
+                            }
+                            for (uint32_t a : beaten) {
+                                unlink(a);
+                                inHierarchy[a] = 0;
+                            }
+                        }
+                        uint32_t arc = ch.addArc(u, w, primary, secondary, v);
+                        inHierarchy.push_back(1);
+                        arcTies.emplace_back();
+                        outArcs[u].push_back(arc);
+                        inArcs[w].push_back(arc);
+                    }
+                    for (uint32_t a : outArcs[u]) directArc[ch.arcTarget[a]] = NO_EDGE;
+                }
+                begin = end;
+            }
+
+            if (apply) {
+                for (uint32_t a : inArcs[v]) {
+                    CityId u = ch.arcSource[a];
+                    vector<uint32_t>& arcs = outArcs[u];
+                    arcs.erase(remove(arcs.begin(), arcs.end(), a), arcs.end());
+                    contractedNeighbours[u]++;
+                }
+                for (uint32_t b : outArcs[v]) {
+                    CityId w = ch.arcTarget[b];
+                    vector<uint32_t>& arcs = inArcs[w];
+                    arcs.erase(remove(arcs.begin(), arcs.end(), b), arcs.end());
+                    contractedNeighbours[w]++;
+                }
+                inArcs[v].clear();
+                outArcs[v].clear();
+                contracted[v] = 1;
+            }
+            return added;
+        };
+
+        auto importance = [&](CityId v) {
+            return (long long)contract(v, false) - (long long)(inArcs[v].size() + outArcs[v].size())
+                + contractedNeighbours[v];
+        };
+
+        typedef pair<long long, CityId> QueueEntry;
+        priority_queue<QueueEntry, vector<QueueEntry>, greater<QueueEntry>> order;
+        for (CityId v = 0; v < n; v++) {
+            order.push({ importance(v), v });
+        }
+
+        uint32_t nextRank = 0;
+        while (!order.empty() && n - nextRank > coreCities) {
+            CityId v = order.top().second;
+            order.pop();
+            if (contracted[v]) continue;
+
+            // Lazy update: contract v only if it is still the least important
+            long long current = importance(v);
+            if (!order.empty() && current > order.top().first) {
+                order.push({ current, v });
+                continue;
+            }
+            contract(v, true);
+            ch.rank[v] = nextRank++;
+        }
+
+        // Whatever is left is the core
+        ch.coreRank = nextRank;
+        while (!order.empty()) {
+            CityId v = order.top().second;
+            order.pop();
+            if (!contracted[v]) {
+                contracted[v] = 1;
+                ch.rank[v] = nextRank++;
+            }
         }
-        sort(cityConnections.begin(), cityConnections.end(),
-            [](const pair<string, int>& a, const pair<string, int>& b) {
-                return a.second > b.second;
-            });
 
-        cout << "\nTop Hub Cities:\n";
-        for (size_t i = 0; i < min(size_t(5), cityConnections.size()); i++) {
-            cout << "   " << (i + 1) << ". "
-                << getCityName(cityConnections[i].first)
-                << " - " << cityConnections[i].second << " outbound flights\n";
+        // Split the arcs into the upward and downward search graphs
+        size_t arcCount = ch.arcSource.size();
+        ch.firstUpArc.assign(n + 1, 0);
+        ch.firstDownArc.assign(n + 1, 0);
+        auto isUp = [&](CityId u, CityId v) {
+            return ch.rank[v] > ch.rank[u] || ch.rank[v] >= ch.coreRank;
+        };
+        auto isDown = [&](CityId u, CityId v) {
+            return ch.rank[u] > ch.rank[v] && ch.rank[v] < ch.coreRank;
+        };
+        for (uint32_t a = 0; a < arcCount; a++) {
+            if (!inHierarchy[a]) continue;
+            CityId u = ch.arcSource[a];
+            CityId v = ch.arcTarget[a];
+            if (isUp(u, v)) ch.firstUpArc[u + 1]++;
+            if (isDown(u, v)) ch.firstDownArc[v + 1]++;
+        }
+        for (size_t v = 0; v < n; v++) {
+            ch.firstUpArc[v + 1] += ch.firstUpArc[v];
+            ch.firstDownArc[v + 1] += ch.firstDownArc[v];
+        }
+        ch.upArcs.resize(ch.firstUpArc[n]);
+        ch.downArcs.resize(ch.firstDownArc[n]);
+        vector<uint32_t> upCursor(ch.firstUpArc.begin(), ch.firstUpArc.end() - 1);
+        vector<uint32_t> downCursor(ch.firstDownArc.begin(), ch.firstDownArc.end() - 1);
+        ch.firstTiedMiddle.assign(arcCount + 1, 0);
+        for (uint32_t a = 0; a < arcCount; a++) {
+            ch.firstTiedMiddle[a + 1] = ch.firstTiedMiddle[a];
+            if (!inHierarchy[a]) continue;
+            CityId u = ch.arcSource[a];
+            CityId v = ch.arcTarget[a];
+            if (isUp(u, v)) ch.upArcs[upCursor[u]++] = a;
+            if (isDown(u, v)) ch.downArcs[downCursor[v]++] = a;
+            ch.tiedMiddles.insert(ch.tiedMiddles.end(), arcTies[a].begin(), arcTies[a].end());
+            ch.firstTiedMiddle[a + 1] = (uint32_t)ch.tiedMiddles.size();
         }
-        cout << "\n";
     }
 
-    // List available cities (unchanged)
-    void listCities() {
-        cout << "\nAVAILABLE CITIES\n";
-        cout << string(70, '-') << "\n";
+    // Arcs of the flight network itself for bidirectionalQuery()
+    BidirectionalArcs flightArcs(const FlatGraph& g, bool optimizeByCost) const {
+        BidirectionalArcs arcs;
+        arcs.firstForward = g.firstEdge.data;
+        arcs.forwardArcs = nullptr;
+        arcs.firstBackward = g.firstInEdge.data();
+        arcs.backwardArcs = g.inEdges.data();
+        arcs.arcSource = g.edgeSource.data();
+        arcs.arcTarget = g.edgeDest.data;
+        arcs.arcPrimary = optimizeByCost ? g.edgeCost.data : g.edgeDuration.data;
+        arcs.arcSecondary = optimizeByCost ? g.edgeDuration.data : g.edgeCost.data;
+        arcs.hierarchy = nullptr;
+        return arcs;
+    }
 
-        vector<pair<string, string>> cityList;
-        for (const auto& pair : cities) {
-            cityList.push_back({ pair.first, pair.second.name });
+    // Upward and downward arcs of a contraction hierarchy for bidirectionalQuery()
+    BidirectionalArcs hierarchyArcs(const ContractionHierarchy& ch) const {
+        BidirectionalArcs arcs;
+        arcs.firstForward = ch.firstUpArc.data();
+        arcs.forwardArcs = ch.upArcs.data();
+        arcs.firstBackward = ch.firstDownArc.data();
+        arcs.backwardArcs = ch.downArcs.data();
+        arcs.arcSource = ch.arcSource.data();
+        arcs.arcTarget = ch.arcTarget.data();
+        arcs.arcPrimary = ch.arcPrimary.data();
+        arcs.arcSecondary = ch.arcSecondary.data();
+        arcs.hierarchy = &ch;
+        return arcs;
+    }
+
+    // Bidirectional Dijkstra: a forward search from source and a backward
+    // search from dest, always advancing the one with the smaller queue
+    // minimum. On the flight network it stops once the two minimums together
+    // exceed the best route seen; on a contraction hierarchy (upward searches
+    // only) once both minimums alone do. Every optimal route, found either at
+    // a city both searches reached or across an arc between them, is then
+    // unpacked into flights and returned, like dijkstra() does.
+    vector<Route> bidirectionalQuery(const FlatGraph& g, const string& source, const string& dest,
+        const BidirectionalArcs& arcs, SearchWorkspace& ws) const {
+        vector<Route> finalRoutes;
+
+        CityId src = g.findCity(source);
+        CityId dst = g.findCity(dest);
+        if (src == INVALID_CITY || dst == INVALID_CITY) {
+            return finalRoutes; // Unknown city, no path
         }
-        sort(cityList.begin(), cityList.end());
 
-        for (const auto& city : cityList) {
-            cout << left << setw(6) << city.first << " - " << city.second << "\n";
+        ws.begin(g.cityCount());
+        ws.reach(src);
+        ws.reach(dst);
+        ws.distance[src] = 0;
+        ws.secondaryDistance[src] = 0;
+        ws.backwardDistance[dst] = 0;
+        ws.backwardSecondary[dst] = 0;
+        ws.heap.push_back({ src, 0, 0, 0 });
+        ws.backwardHeap.push_back({ dst, 0, 0, 0 });
+        vector<CityId>& forwardSettled = ws.queue;
+        greater<PQNode> heapOrder;
+        double bestPrimary = INF;
+
+        // Settle the next city of one direction and relax its arcs (same tie rules as dijkstra())
+        auto step = [&](bool forward) {
+            vector<PQNode>& pq = forward ? ws.heap : ws.backwardHeap;
+            vector<double>& distance = forward ? ws.distance : ws.backwardDistance;
+            vector<double>& secondaryDistance = forward ? ws.secondaryDistance : ws.backwardSecondary;
+            vector<vector<pair<CityId, uint32_t>>>& parents = forward ? ws.parentCandidates : ws.backwardParents;
+            const vector<double>& otherDistance = forward ? ws.backwardDistance : ws.distance;
+
+            pop_heap(pq.begin(), pq.end(), heapOrder);
+            PQNode current = pq.back();
+            pq.pop_back();
+            CityId u = current.city;
+            if (current.cost > distance[u] + EPSILON) return;
+            if (abs(current.cost - distance[u]) < EPSILON && current.duration > secondaryDistance[u] + EPSILON) return;
+
+            ws.settled++;
+            if (forward) forwardSettled.push_back(u);
+            bestPrimary = min(bestPrimary, distance[u] + otherDistance[u]);
+
+            const uint32_t* first = forward ? arcs.firstForward : arcs.firstBackward;
+            const uint32_t* list = forward ? arcs.forwardArcs : arcs.backwardArcs;
+
+            // Stall on demand: on a hierarchy u can be settled at a distance that
+            // an arc from a more important city already beats; its arcs cannot
+            // lead to an optimal route then
+            if (arcs.hierarchy && first[u] != first[u + 1]) {
+                const uint32_t* reverseFirst = forward ? arcs.firstBackward : arcs.firstForward;
+                const uint32_t* reverseList = forward ? arcs.backwardArcs : arcs.forwardArcs;
+                for (uint32_t i = reverseFirst[u]; i < reverseFirst[u + 1]; i++) {
+                    uint32_t a = reverseList[i];
+                    CityId x = forward ? arcs.arcSource[a] : arcs.arcTarget[a];
+                    if (ws.reached(x) && weightLess(distance[x] + arcs.arcPrimary[a],
+                        secondaryDistance[x] + arcs.arcSecondary[a], distance[u], secondaryDistance[u])) {
+                        return;
+                    }
+                }
+            }
+            for (uint32_t i = first[u]; i < first[u + 1]; i++) {
+                uint32_t a = list ? list[i] : i;
+                CityId x = forward ? arcs.arcTarget[a] : arcs.arcSource[a];
+                ws.reach(x);
+
+                double newPrimary = distance[u] + arcs.arcPrimary[a];
+                double newSecondary = secondaryDistance[u] + arcs.arcSecondary[a];
+                if (weightLess(newPrimary, newSecondary, distance[x], secondaryDistance[x])) {
+                    distance[x] = newPrimary;
+                    secondaryDistance[x] = newSecondary;
+                    parents[x].clear();
+                    pq.push_back({ x, newPrimary, newSecondary, newPrimary });
+                    push_heap(pq.begin(), pq.end(), heapOrder);
+                    bestPrimary = min(bestPrimary, newPrimary + otherDistance[x]);
+                }
+                else if (!weightTied(newPrimary, newSecondary, distance[x], secondaryDistance[x])) {
+                    continue;
+                }
+                parents[x].push_back({ u, a });
+            }
+        };
+
+        while (!ws.heap.empty() || !ws.backwardHeap.empty()) {
+            double forwardTop = ws.heap.empty() ? INF : ws.heap.front().priority;
+            double backwardTop = ws.backwardHeap.empty() ? INF : ws.backwardHeap.front().priority;
+            double reachable = arcs.hierarchy ? min(forwardTop, backwardTop) : forwardTop + backwardTop;
+            if (reachable > bestPrimary + EPSILON) break;
+            step(forwardTop <= backwardTop);
+        }
+        if (bestPrimary >= INF) {
+            return finalRoutes;
         }
-        cout << "\nTotal: " << cityList.size() << " cities\n\n";
-    }
 
-private:
-    // Generic Dijkstra implementation
-    vector<Route> dijkstra(const string& source, const string& dest, bool optimizeByCost) {
+        // Meeting points: a forward-settled city u the backward search reached
+        // (arc == NO_EDGE), or a forward arc from u to such a city. On a
+        // hierarchy both searches settle the most important city of every
+        // optimal route, so meeting at cities is enough.
+        struct Meeting {
+            CityId from;
+            uint32_t arc;
+            CityId to;
+            double primary;
+            double secondary;
+        };
+        vector<Meeting> meetings;
+        double bestSecondary = INF;
+        bestPrimary = INF;
+        auto meet = [&](CityId u, uint32_t a, CityId v, double primary, double secondary) {
+            if (weightLess(primary, secondary, bestPrimary, bestSecondary)) {
+                bestPrimary = primary;
+                bestSecondary = secondary;
+            }
+            meetings.push_back({ u, a, v, primary, secondary });
+        };
+        for (CityId u : forwardSettled) {
+            if (ws.backwardDistance[u] < INF) {
+                meet(u, NO_EDGE, u, ws.distance[u] + ws.backwardDistance[u],
+                    ws.secondaryDistance[u] + ws.backwardSecondary[u]);
+            }
+            if (arcs.hierarchy) continue;
+            for (uint32_t i = arcs.firstForward[u]; i < arcs.firstForward[u + 1]; i++) {
+                uint32_t a = arcs.forwardArcs ? arcs.forwardArcs[i] : i;
+                CityId v = arcs.arcTarget[a];
+                if (!ws.reached(v) || ws.backwardDistance[v] >= INF) continue;
+                meet(u, a, v, ws.distance[u] + arcs.arcPrimary[a] + ws.backwardDistance[v],
+                    ws.secondaryDistance[u] + arcs.arcSecondary[a] + ws.backwardSecondary[v]);
+            }
+        }
 
-        // Store the best primary metric distance (cost or duration depending on optimizeByCost)
-        unordered_map<string, double> distance;
-        // Store the secondary metric for tiebreaking
-        unordered_map<string, double> secondaryDistance;
+        set<vector<uint32_t>> seen;
+        PathArena& upPaths = ws.paths;
+        PathArena& downPaths = ws.backwardPaths;
+        vector<uint32_t> path;
+        vector<vector<uint32_t>> unpacked;
+        for (const Meeting& meeting : meetings) {
+            if (!weightTied(meeting.primary, meeting.secondary, bestPrimary, bestSecondary)) continue;
+
+            upPaths.clear();
+            downPaths.clear();
+            collectArcPaths(meeting.from, src, ws.parentCandidates, true, ws, upPaths);
+            collectArcPaths(meeting.to, dst, ws.backwardParents, false, ws, downPaths);
+            for (size_t up = 0; up < upPaths.size(); up++) {
+                for (size_t down = 0; down < downPaths.size(); down++) {
+                    path.assign(upPaths.begin(up), upPaths.end(up));
+                    if (meeting.arc != NO_EDGE) path.push_back(meeting.arc);
+                    path.insert(path.end(), downPaths.begin(down), downPaths.end(down));
+                    unpacked.clear();
+                    if (arcs.hierarchy) arcs.hierarchy->unpack(path, unpacked);
+                    else unpacked.push_back(path);
+                    for (const vector<uint32_t>& edges : unpacked) {
+                        if (seen.insert(edges).second) {
+                            finalRoutes.push_back(buildRoute(g, src, edges));
+                        }
+                    }
+                }
+            }
+        }
 
-        // Store multiple optimal parents: city -> list of (parent_city, flight_used)
-        unordered_map<string, vector<pair<string, Flight>>> parentCandidates;
+        return finalRoutes;
+    }
 
-        priority_queue<PQNode, vector<PQNode>, greater<PQNode>> pq;
+    // Bidirectional BFS: expand one whole level at a time from whichever end
+    // has the smaller frontier. The first level that links the two searches
+    // crosses every route with the fewest stops, so the search stops after
+    // finishing it. Each side keeps the cheapest (then fastest) route with the
+    // fewest flights to or from every city it reached, and the link with the
+    // best total is taken, so the route is the one findMinimumStops() returns
+    // (up to routes that tie on stops, cost and duration).
+    Route bidirectionalMinimumStops(const FlatGraph& g, const string& source, const string& dest,
+        SearchWorkspace& ws) const {
+        Route route;
 
-        // Initialize cities with outbound flights
-        for (const auto& pair : adjList) {
-            distance[pair.first] = INF;
-            secondaryDistance[pair.first] = INF;
+        CityId src = g.findCity(source);
+        CityId dst = g.findCity(dest);
+        if (src == INVALID_CITY || dst == INVALID_CITY) {
+            return route; // Unknown city, no path
+        }
 
-            // Also initialize all destinations reachable from this city
-            for (const Flight& flight : pair.second) {
-                if (distance.find(flight.destination) == distance.end()) {
-                    distance[flight.destination] = INF;
-                    secondaryDistance[flight.destination] = INF;
+        ws.begin(g.cityCount());
+        ws.reach(src);
+        ws.reach(dst);
+        ws.hops[src] = 0;
+        ws.backwardHops[dst] = 0;
+        ws.distance[src] = 0;
+        ws.secondaryDistance[src] = 0;
+        ws.backwardDistance[dst] = 0;
+        ws.backwardSecondary[dst] = 0;
+        ws.queue.push_back(src);
+        ws.backwardQueue.push_back(dst);
+
+        // Best link: forward path to meetFrom, then meetEdge (unless NO_EDGE), then backward path from meetTo
+        int bestHops = src == dst ? 0 : numeric_limits<int>::max();
+        double bestCost = 0, bestDuration = 0;
+        CityId meetFrom = src;
+        uint32_t meetEdge = NO_EDGE;
+        CityId meetTo = src;
+
+        size_t forwardHead = 0, backwardHead = 0;
+        while (bestHops == numeric_limits<int>::max() &&
+            forwardHead < ws.queue.size() && backwardHead < ws.backwardQueue.size()) {
+            bool forward = ws.queue.size() - forwardHead <= ws.backwardQueue.size() - backwardHead;
+            vector<CityId>& queue = forward ? ws.queue : ws.backwardQueue;
+            size_t& head = forward ? forwardHead : backwardHead;
+            vector<int>& hops = forward ? ws.hops : ws.backwardHops;
+            vector<int>& otherHops = forward ? ws.backwardHops : ws.hops;
+            vector<double>& cost = forward ? ws.distance : ws.backwardDistance;
+            vector<double>& duration = forward ? ws.secondaryDistance : ws.backwardSecondary;
+            vector<double>& otherCost = forward ? ws.backwardDistance : ws.distance;
+            vector<double>& otherDuration = forward ? ws.backwardSecondary : ws.secondaryDistance;
+            vector<uint32_t>& parentEdge = forward ? ws.parentEdge : ws.backwardParentEdge;
+
+            for (size_t levelEnd = queue.size(); head < levelEnd; head++) {
+                CityId current = queue[head];
+                ws.settled++;
+
+                uint32_t begin = forward ? g.firstEdge[current] : g.firstInEdge[current];
+                uint32_t end = forward ? g.firstEdge[current + 1] : g.firstInEdge[current + 1];
+                for (uint32_t i = begin; i < end; i++) {
+                    uint32_t e = forward ? i : g.inEdges[i];
+                    CityId next = forward ? g.edgeDest[e] : g.edgeSource[e];
+                    ws.reach(next);
+                    double viaCost = cost[current] + g.edgeCost[e];
+                    double viaDuration = duration[current] + g.edgeDuration[e];
+
+                    if (otherHops[next] >= 0) {
+                        int linkHops = hops[current] + 1 + otherHops[next];
+                        double linkCost = viaCost + otherCost[next];
+                        double linkDuration = viaDuration + otherDuration[next];
+                        if (linkHops < bestHops ||
+                            (linkHops == bestHops && weightLess(linkCost, linkDuration, bestCost, bestDuration))) {
+                            bestHops = linkHops;
+                            bestCost = linkCost;
+                            bestDuration = linkDuration;
+                            meetFrom = forward ? current : next;
+                            meetEdge = e;
+                            meetTo = forward ? next : current;
+                        }
+                    }
+                    if (hops[next] < 0) {
+                        hops[next] = hops[current] + 1;
+                        queue.push_back(next);
+                    }
+                    else if (hops[next] != hops[current] + 1) {
+                        continue;
+                    }
+                    if (weightLess(viaCost, viaDuration, cost[next], duration[next])) {
+                        cost[next] = viaCost;
+                        duration[next] = viaDuration;
+                        parentEdge[next] = e;
+                    }
                 }
             }
         }
 
-        // Ensure source and destination are initialized 
-        if (distance.find(source) == distance.end()) {
-            distance[source] = INF;
-            secondaryDistance[source] = INF;
-        }
-        if (distance.find(dest) == distance.end()) {
-            distance[dest] = INF;
-            secondaryDistance[dest] = INF;
+        if (bestHops == numeric_limits<int>::max()) {
+            return route; // No path found
         }
 
-        // Start from source
-        distance[source] = 0;
-        secondaryDistance[source] = 0;
+        vector<uint32_t> edges;
+        for (CityId city = meetFrom; city != src; city = g.edgeSource[ws.parentEdge[city]]) {
+            edges.push_back(ws.parentEdge[city]);
+        }
+        reverse(edges.begin(), edges.end());
+        if (meetEdge != NO_EDGE) edges.push_back(meetEdge);
+        for (CityId city = meetTo; city != dst; city = g.edgeDest[ws.backwardParentEdge[city]]) {
+            edges.push_back(ws.backwardParentEdge[city]);
+        }
+        return buildRoute(g, src, edges);
+    }
 
-        pq.push({ source, 0, 0 });
+    // Generic Dijkstra implementation over the CSR arrays. With goalDirected set
+    // it runs as A*: the queue is ordered by the primary metric plus a lower
+    // bound to dest (great-circle for duration, landmarks for either metric,
+    // whichever is larger), and the search stops once no queued city can still
+    // lead to a route as good as the best one found. With a filter, only the
+    // flights and transit airports it allows are used. With integer weights
+    // every total is a whole number of cents or minutes, so the EPSILON
+    // comparisons below decide ties exactly.
+    vector<Route> dijkstra(const FlatGraph& g, const string& source, const string& dest, bool optimizeByCost,
+        SearchWorkspace& ws, bool goalDirected = false, const SearchFilter* filter = nullptr) const {
+        return withSearchQueue(ws, [&](auto& pq) {
+            return dijkstra(g, source, dest, optimizeByCost, ws, pq, goalDirected, filter);
+        });
+    }
 
-        while (!pq.empty()) {
-            PQNode current = pq.top();
-            pq.pop();
+    template <typename Queue>
+    vector<Route> dijkstra(const FlatGraph& g, const string& source, const string& dest, bool optimizeByCost,
+        SearchWorkspace& ws, Queue& pq, bool goalDirected, const SearchFilter* filter) const {
+        vector<Route> finalRoutes;
 
-            string currentCity = current.city;
-            double currentPrimaryDist = current.cost;    // Primary metric from PQ
-            double currentSecondaryDist = current.duration; // Secondary metric from PQ
+        CityId src = g.findCity(source);
+        CityId dst = g.findCity(dest);
+        if (src == INVALID_CITY || dst == INVALID_CITY) {
+            return finalRoutes; // Unknown city, no path
+        }
 
-            if (currentPrimaryDist > distance[currentCity] + EPSILON) {
-                continue;
-            }
-            // Also skip if primary is equal but secondary is worse
-            if (abs(currentPrimaryDist - distance[currentCity]) < EPSILON &&
-                currentSecondaryDist > secondaryDistance[currentCity] + EPSILON) {
-                continue;
+        // Define primary and secondary metrics based on optimization goal
+        const Column<double>& primaryWeight = optimizeByCost ? g.edgeCost : g.edgeDuration;
+        const Column<double>& secondaryWeight = optimizeByCost ? g.edgeDuration : g.edgeCost;
+        bool filterFlights = filter && filter->restrictsFlights;
+        bool filterTransits = filter && filter->restrictsTransits;
+
+        // Best primary metric (cost or duration depending on optimizeByCost), the secondary
+        // metric for tiebreaking and all optimal (parent_city, edge) pairs live in the workspace
+        ws.begin(g.cityCount());
+        pq.reset(g.cityCount());
+        vector<double>& distance = ws.distance;
+        vector<double>& secondaryDistance = ws.secondaryDistance;
+        vector<vector<pair<CityId, uint32_t>>>& parentCandidates = ws.parentCandidates;
+
+        // The great-circle bound only applies to duration
+        bool useGeo = goalDirected && !optimizeByCost && g.maxCruiseSpeed > 0;
+        bool useLandmarks = goalDirected && g.landmarkTables;
+        goalDirected = useGeo || useLandmarks;
+        auto reachCity = [&](CityId u) {
+            if (ws.reached(u)) return;
+            ws.reach(u);
+            if (useGeo) ws.potential[u] = g.travelTimeLowerBound(u, dst);
+            if (useLandmarks) {
+                ws.potential[u] = max(ws.potential[u], g.landmarkTables->lowerBound(u, dst, optimizeByCost));
             }
+        };
 
-            // Check if current city has outbound flights
-            if (adjList.find(currentCity) == adjList.end()) {
-                continue; // Dead-end city, no outbound flights
+        // Start from source (dest is reached up front so distance[dst] is valid for the A* stop test)
+        reachCity(dst);
+        reachCity(src);
+        distance[src] = 0;
+        secondaryDistance[src] = 0;
+
+        pq.push(src, ws.potential[src]);
+
+        while (!pq.empty()) {
+            // Every remaining city (plus its lower bound, if any) is worse than
+            // the best route to dest, so nothing left can match or improve it
+            if (pq.minKey() > distance[dst] + EPSILON) {
+                break;
             }
 
-            // Relax all edges from current city
-            for (const Flight& flight : adjList[currentCity]) {
-                string nextCity = flight.destination;
+            CityId currentCity = pq.pop();
+            ws.settled++;
+            if (filterTransits && currentCity != src && !filter->allowsTransit(currentCity)) continue;
 
-                // Define primary and secondary metrics based on optimization goal
-                double primaryWeight = optimizeByCost ? flight.cost : flight.duration;
-                double secondaryWeight = optimizeByCost ? flight.duration : flight.cost;
+            // Relax all edges from current city (dead-end cities have an empty range)
+            for (uint32_t e = g.firstEdge[currentCity]; e < g.firstEdge[currentCity + 1]; e++) {
+                if (filterFlights && !filter->allowsFlight(g, e)) continue;
+                CityId nextCity = g.edgeDest[e];
+                reachCity(nextCity);
+                if (ws.potential[nextCity] >= INF) continue; // landmarks prove dest is unreachable from here
 
-                double newPrimaryDist = distance[currentCity] + primaryWeight;
-                double newSecondaryDist = secondaryDistance[currentCity] + secondaryWeight;
+                double newPrimaryDist = distance[currentCity] + primaryWeight[e];
+                double newSecondaryDist = secondaryDistance[currentCity] + secondaryWeight[e];
 
                 bool replace = false; // New path strictly better
                 bool append = false;  // New path equally good (alternative route)
@@ -1058,23 +5957,21 @@ private:
                         secondaryDistance[nextCity] = newSecondaryDist;
                         // Clear old parent candidates (they're now dominated)
                         parentCandidates[nextCity].clear();
-                        // Push to priority queue with both metrics
-                        pq.push({ nextCity, newPrimaryDist, newSecondaryDist });
+                        // Queue it, or move it up if it is queued already
+                        pq.push(nextCity, newPrimaryDist + ws.potential[nextCity]);
                     }
 
                     // Add this parent as a candidate (for both replace and append cases)
-                    parentCandidates[nextCity].push_back({ currentCity, flight });
+                    parentCandidates[nextCity].push_back({ currentCity, e });
                 }
             }
         }
 
-        //path reconstruction check
-        vector<Route> finalRoutes;
-
         // Check if destination was reached
-        if (distance.find(dest) != distance.end() && distance[dest] < INF - EPSILON) {
-            // Use the recursive helper to find ALL optimal paths
-            reconstructAllPaths(dest, source, parentCandidates, finalRoutes, Route());
+        if (ws.reached(dst) && distance[dst] < INF - EPSILON) {
+            // Enumerate ALL optimal paths through the parent candidates
+            collectArcPaths(dst, src, parentCandidates, true, ws, ws.paths);
+            buildRoutes(g, src, ws.paths, finalRoutes);
         }
 
         return finalRoutes;
@@ -1083,26 +5980,740 @@ private:
 
 
 
-int main() {
+//--------------------BATCH QUERIES---------------------------
+
+// Append str as a JSON string literal
+void appendJsonString(string& out, const string& str) {
+    out += '"';
+    for (char c : str) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if ((unsigned char)c < 0x20) {
+                out += "\\u00";
+                out += "0123456789abcdef"[(c >> 4) & 0xF];
+                out += "0123456789abcdef"[c & 0xF];
+            }
+            else {
+                out += c;
+            }
+        }
+    }
+    out += '"';
+}
+
+void appendJsonNumber(string& out, double value) {
+    char text[32];
+    snprintf(text, sizeof(text), "%.10g", value);
+    out += text;
+}
+
+void appendRouteJson(string& out, const Route& route) {
+    out += "{\"cost\":";
+    appendJsonNumber(out, route.totalCost);
+    out += ",\"duration\":";
+    appendJsonNumber(out, route.totalDuration);
+    out += ",\"stops\":";
+    out += to_string(route.stops);
+    out += ",\"path\":[";
+    for (size_t i = 0; i < route.cities.size(); i++) {
+        if (i > 0) out += ',';
+        appendJsonString(out, route.cities[i]);
+    }
+    out += "],\"flights\":[";
+    for (size_t i = 0; i < route.flights.size(); i++) {
+        if (i > 0) out += ',';
+        appendJsonString(out, route.flights[i].flightNo);
+    }
+    out += "]}";
+}
+
+// One line of batch input and its JSON result
+struct BatchRequest {
+    size_t number;     // 1-based position in the input
+    bool malformed;
+    bool failed;       // result is an error record
+    string id;
+    string source;
+    string dest;
+    string objective;
+    string departure;  // "Mon 08:00", for earliest_arrival
+    RouteFilter filter; // party size and airline/transit restrictions for cheapest, fastest, min_stops and pareto
+    size_t alternatives; // routes wanted by k_cheapest and k_fastest
+    string update;     // inventory update kind; empty for route requests
+    Flight flight;     // flight fields of an update
+    string result;
+
+    bool isUpdate() const { return !malformed && !update.empty(); }
+};
+
+// Answer one batch request into request.result using the caller's workspace
+void runBatchRequest(const FlightGraph& graph, BatchRequest& request, SearchWorkspace& ws) {
+    string& out = request.result;
+    out.clear();
+    request.failed = true;
+
+    if (request.malformed) {
+        out += "{\"request\":";
+        out += to_string(request.number);
+        out += ",\"error\":\"malformed request\"}\n";
+        return;
+    }
+
+    out += '{';
+    if (!request.id.empty()) {
+        out += "\"id\":";
+        appendJsonString(out, request.id);
+        out += ',';
+    }
+    out += "\"source\":";
+    appendJsonString(out, request.source);
+    out += ",\"destination\":";
+    appendJsonString(out, request.dest);
+    out += ",\"objective\":";
+    appendJsonString(out, request.objective);
+    if (request.filter.passengers > 0) {
+        out += ",\"passengers\":";
+        out += to_string(request.filter.passengers);
+    }
+
+    vector<Route> routes;
+    const string& objective = request.objective;
+    if (objective == "earliest_arrival") {
+        int departAt = parseWeekMinute(request.departure);
+        if (departAt < 0) {
+            out += ",\"error\":\"invalid departure\"}\n";
+            return;
+        }
+        departAt = graph.localToUtc(request.source, departAt);
+        Itinerary itinerary = graph.findEarliestArrival(request.source, request.dest, departAt, ws);
+        if (!itinerary.route.cities.empty()) {
+            routes.push_back(itinerary.route);
+            out += ",\"departure\":";
+            appendJsonString(out, formatWeekMinute(graph.utcToLocal(request.source, itinerary.departures.front())));
+            out += ",\"arrival\":";
+            appendJsonString(out, formatWeekMinute(graph.utcToLocal(request.dest, itinerary.arrivals.back())));
+        }
+    }
+    else if (objective == "cheapest") {
+        routes = graph.findCheapestRoute(request.source, request.dest, request.filter, ws);
+    }
+    else if (objective == "fastest") {
+        routes = graph.findFastestRoute(request.source, request.dest, request.filter, ws);
+    }
+    else if (objective == "min_stops") {
+        Route route = graph.findMinimumStops(request.source, request.dest, request.filter, ws);
+        if (!route.cities.empty()) routes.push_back(route);
+    }
+    else if (objective == "pareto") {
+        routes = graph.findParetoOptimalRoutes(request.source, request.dest, request.filter, ws);
+    }
+    else if (objective == "k_cheapest" || objective == "k_fastest") {
+        routes = graph.findAlternativeRoutes(request.source, request.dest, objective == "k_cheapest",
+            request.alternatives, ws);
+    }
+    else if (objective == "pareto_stops") {
+        routes = graph.findParetoRoutes(request.source, request.dest,
+            CRITERION_COST | CRITERION_DURATION | CRITERION_HOPS, ws);
+    }
+    else if (objective == "pareto_layover") {
+        routes = graph.findParetoRoutes(request.source, request.dest,
+            CRITERION_COST | CRITERION_DURATION | CRITERION_HOPS | CRITERION_LAYOVER, ws);
+    }
+    else {
+        out += ",\"error\":\"unknown objective\"}\n";
+        return;
+    }
+
+    out += ",\"settled\":";
+    out += to_string(ws.settled);
+    out += ",\"routes\":[";
+    for (size_t i = 0; i < routes.size(); i++) {
+        if (i > 0) out += ',';
+        appendRouteJson(out, routes[i]);
+    }
+    out += "]}\n";
+    request.failed = false;
+}
+
+// Stage one inventory update from a batch stream, writing its result record
+void applyBatchUpdate(FlightGraph& graph, BatchRequest& request) {
+    string& out = request.result;
+    out.clear();
+    request.failed = true;
+
+    out += '{';
+    if (!request.id.empty()) {
+        out += "\"id\":";
+        appendJsonString(out, request.id);
+        out += ',';
+    }
+    out += "\"update\":";
+    appendJsonString(out, request.update);
+    out += ",\"flight_number\":";
+    appendJsonString(out, request.flight.flightNo);
+
+    const Flight& f = request.flight;
+    string error;
+    if (f.flightNo.empty()) {
+        error = "missing flight_number";
+    }
+    else if (request.update == "seats") {
+        if (f.seatsAvailable < 0) error = "missing seats_available";
+        else if (!graph.updateSeats(f.flightNo, f.seatsAvailable)) error = "unknown flight";
+    }
+    else if (request.update == "fare") {
+        if (f.cost < 0) error = "missing cost_usd";
+        else if (!graph.updateFare(f.flightNo, f.cost)) error = "unknown flight";
+    }
+    else if (request.update == "cancel") {
+        if (!graph.cancelFlight(f.flightNo)) error = "unknown flight";
+    }
+    else if (request.update == "add") {
+        if (request.source.empty() || request.dest.empty()) error = "missing source or destination";
+        else if (f.cost < 0) error = "missing cost_usd";
+        else if (graph.hasFlight(f.flightNo)) error = "duplicate flight";
+        else {
+            graph.addFlight(request.source, request.dest, f.flightNo, f.duration, f.cost, f.airline,
+                f.departureTime, f.arrivalTime, f.aircraft, max(0, f.seatsAvailable), f.frequency);
+        }
+    }
+    else {
+        error = "unknown update";
+    }
+
+    if (error.empty()) {
+        out += ",\"status\":\"applied\"}\n";
+        request.failed = false;
+    }
+    else {
+        out += ",\"error\":";
+        appendJsonString(out, error);
+        out += "}\n";
+    }
+}
+
+// Non-interactive mode: read one JSON request per line and write one JSON result per line.
+//   {"id": "q1", "source": "KHI", "destination": "LHR", "objective": "cheapest"}
+// objective is one of "cheapest", "fastest", "min_stops", "pareto" (cost and
+// duration), "pareto_stops" (plus stops), "pareto_layover" (plus layover
+// time) or "earliest_arrival" (by timetable, leaving at or after the local
+// "departure", e.g. "Mon 08:00"; the result adds the actual local departure
+// and arrival times);
+// cheapest, fastest, min_stops and pareto requests may be restricted with
+// "passengers" (seats needed on every flight), "airlines" and
+// "exclude_airlines" (airline names) and "transit_airports" and
+// "exclude_transit" (airport codes), each list an array of strings;
+// "k_cheapest" and "k_fastest" return up to "k" (default 20) loopless
+// routes, best first;
+// id is optional and echoed back. Each result carries a "routes" array, or an "error" message.
+// Lines with an "update" field change the flight inventory instead:
+//   {"update": "fare", "flight_number": "PK-203", "cost_usd": 275}
+// update is "seats" (seats_available), "fare" (cost_usd), "cancel" or "add"
+// (a full flight record as in flights.json). Updates take effect for the
+// requests after them.
+// Requests are read in blocks; with threads > 1 each block is answered by a
+// thread pool whose workers each own a search workspace, and results are
+// written in input order. A run of updates forms its own block, applied
+// once the searches before it have finished.
+int runBatchQueries(FlightGraph& graph, istream& in, ostream& out, int threads) {
+    const size_t BLOCK_SIZE = 4096;
+
+    graph.freeze(); // searches below only read the graph
+
+    unique_ptr<ThreadPool> pool;
+    if (threads > 1) {
+        pool.reset(new ThreadPool((size_t)threads));
+    }
+    vector<SearchWorkspace> workspaces(pool ? pool->size() : 1);
+
+    JsonReader reader(in);
+    vector<BatchRequest> block(BLOCK_SIZE + 1); // the last slot holds a request carried to the next block
+    string key;
+    size_t queries = 0;
+    size_t updates = 0;
+    size_t errors = 0;
+    bool carried = false;
+
+    // Updates can leave the landmark tables or hierarchies stale; searches
+    // then run without them, and once that has cost as much time as building
+    // them took, they are rebuilt (so neither side exceeds twice the other)
+    double staleSeconds = 0;
+
+    auto started = chrono::steady_clock::now();
+
+    while (carried || !reader.atEnd()) {
+        // Parse up to one block of route requests or of updates
+        size_t count = 0;
+        if (carried) {
+            swap(block[0], block[BLOCK_SIZE]);
+            count = 1;
+            carried = false;
+        }
+        while (count < BLOCK_SIZE && !reader.atEnd()) {
+            BatchRequest& request = block[count];
+            request.number = ++queries;
+            request.id.clear();
+            request.source.clear();
+            request.dest.clear();
+            request.objective.clear();
+            request.departure.clear();
+            request.filter = RouteFilter();
+            request.alternatives = DEFAULT_ALTERNATIVES;
+            request.update.clear();
+            request.flight = Flight();
+            request.flight.cost = -1;
+            request.flight.seatsAvailable = -1;
+
+            bool parsed = reader.consume('{');
+            if (parsed) {
+                bool first = true;
+                while (reader.nextKey(key, first)) {
+                    bool ok;
+                    if (key == "id") ok = reader.readStringField(request.id);
+                    else if (key == "source") ok = reader.readStringField(request.source);
+                    else if (key == "destination") ok = reader.readStringField(request.dest);
+                    else if (key == "objective") ok = reader.readStringField(request.objective);
+                    else if (key == "departure") ok = reader.readStringField(request.departure);
+                    else if (key == "passengers") {
+                        double passengers = 0;
+                        ok = reader.readNumberField(passengers);
+                        request.filter.passengers = (int)passengers;
+                    }
+                    else if (key == "k") {
+                        double k = 0;
+                        ok = reader.readNumberField(k);
+                        request.alternatives = (size_t)max(0.0, k);
+                    }
+                    else if (key == "airlines") ok = reader.readStringListField(request.filter.airlines);
+                    else if (key == "exclude_airlines") ok = reader.readStringListField(request.filter.excludedAirlines);
+                    else if (key == "transit_airports") ok = reader.readStringListField(request.filter.transitAirports);
+                    else if (key == "exclude_transit") ok = reader.readStringListField(request.filter.excludedTransits);
+                    else if (key == "update") ok = reader.readStringField(request.update);
+                    else if (!FlightGraph::readFlightField(reader, key, request.flight, ok)) ok = reader.skipValue();
+                    if (!ok) break;
+                }
+                parsed = !reader.failed();
+            }
+
+            request.malformed = !parsed;
+            if (!parsed) {
+                reader.skipLine();
+            }
+
+            transform(request.source.begin(), request.source.end(), request.source.begin(), ::toupper);
+            transform(request.dest.begin(), request.dest.end(), request.dest.begin(), ::toupper);
+
+            if (count > 0 && request.isUpdate() != block[0].isUpdate()) {
+                swap(request, block[BLOCK_SIZE]);
+                carried = true;
+                break;
+            }
+            count++;
+        }
+
+        // Apply a block of updates; searches only start again once they are merged
+        if (block[0].isUpdate()) {
+            for (size_t i = 0; i < count; i++) {
+                applyBatchUpdate(graph, block[i]);
+            }
+            graph.freeze();
+            updates += count;
+        }
+        // Answer a block of route requests
+        else {
+            auto blockStarted = chrono::steady_clock::now();
+            if (pool) {
+                pool->parallelFor(count, [&](size_t worker, size_t i) {
+                    runBatchRequest(graph, block[i], workspaces[worker]);
+                });
+            }
+            else {
+                for (size_t i = 0; i < count; i++) {
+                    runBatchRequest(graph, block[i], workspaces[0]);
+                }
+            }
+            if (graph.preprocessingStale()) {
+                staleSeconds += chrono::duration<double>(chrono::steady_clock::now() - blockStarted).count();
+                if (staleSeconds >= graph.preprocessingTime()) {
+                    graph.refreshPreprocessing();
+                    staleSeconds = 0;
+                }
+            }
+        }
+
+        // Write results in input order
+        for (size_t i = 0; i < count; i++) {
+            if (block[i].failed) errors++;
+            out.write(block[i].result.data(), (streamsize)block[i].result.size());
+        }
+    }
+    out.flush();
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    cerr << "Processed " << queries << " queries";
+    if (updates > 0) cerr << " including " << updates << " updates";
+    cerr << " (" << errors << " errors) in "
+        << fixed << setprecision(3) << seconds << " s";
+    if (seconds > 0) {
+        cerr << " (" << setprecision(0) << queries / seconds << " queries/s)";
+    }
+    cerr << " on " << workspaces.size() << " thread(s)\n";
+
+    RouteCache& cache = graph.routeCache();
+    if (cache.enabled()) {
+        uint64_t hits = cache.hitCount();
+        uint64_t lookups = hits + cache.missCount();
+        cerr << "Result cache: " << hits << " hits / " << lookups << " lookups, "
+            << cache.evictionCount() << " evictions\n";
+    }
+
+    return 0;
+}
+
+// Non-interactive mode: write the route matrix between the given airports
+// (every airport in the network when codes is empty) and report the time taken
+int runRouteMatrix(FlightGraph& graph, const string& filename, vector<string> codes,
+    bool optimizeByCost, int threads) {
+    if (codes.empty()) codes = graph.frozen()->cityCodes;
+
+    auto started = chrono::steady_clock::now();
+    if (!graph.buildRouteMatrix(filename, codes, codes, optimizeByCost, threads)) return 1;
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    cout << " Wrote " << codes.size() << "x" << codes.size() << " "
+        << (optimizeByCost ? "cheapest" : "fastest") << " route matrix to " << filename
+        << " in " << fixed << setprecision(3) << seconds << " s on " << threads << " thread(s)\n";
+    return 0;
+}
+
+// Time square route matrices over the first 20, 100, 1000 and 10000 airports
+// of the network (the sample network has 20, so its first size covers every
+// sample pair; larger sizes are capped at the network size, so the full run
+// needs a network such as --synthetic 10000 200000)
+int runMatrixBenchmark(FlightGraph& graph, bool optimizeByCost, int threads) {
+    const size_t SIZES[] = { 20, 100, 1000, 10000 };
+    const string filename = "route_matrix_benchmark.mtx";
+    shared_ptr<const FlatGraph> version = graph.frozen();
+    const vector<string>& allCodes = version->cityCodes;
+
+    cout << "\nROUTE MATRIX BENCHMARK (" << (optimizeByCost ? "cheapest" : "fastest")
+        << " routes, " << threads << " thread(s))\n";
+    cout << string(60, '-') << "\n";
+    cout << left << setw(14) << "MATRIX" << setw(14) << "SECONDS"
+        << setw(16) << "ORIGINS/S" << "PAIRS/S\n";
+
+    size_t previous = 0;
+    for (size_t size : SIZES) {
+        size = min(size, allCodes.size());
+        if (size == previous) break;
+        previous = size;
+
+        vector<string> codes(allCodes.begin(), allCodes.begin() + size);
+        auto started = chrono::steady_clock::now();
+        bool ok = graph.buildRouteMatrix(filename, codes, codes, optimizeByCost, threads);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        remove(filename.c_str());
+        if (!ok) return 1;
+
+        double rate = seconds > 0 ? size / seconds : 0;
+        cout << left << setw(14) << (to_string(size) + "x" + to_string(size))
+            << setw(14) << fixed << setprecision(3) << seconds
+            << setw(16) << setprecision(0) << rate << rate * size << "\n";
+    }
+    cout << string(60, '-') << "\n";
+    return 0;
+}
+
+// Time the same cheapest and fastest queries on every search queue, once
+// with plain Dijkstra's and once with A*. The city pairs are spread over the
+// network deterministically so runs are comparable; the result cache is off.
+int runQueueBenchmark(FlightGraph& graph, size_t queries) {
+    const QueueKind KINDS[] = { QUEUE_BINARY, QUEUE_QUAD, QUEUE_RADIX };
+    shared_ptr<const FlatGraph> version = graph.frozen();
+    const vector<string>& codes = version->cityCodes;
+    size_t n = codes.size();
+    if (n < 2) return 1;
+
+    vector<pair<string, string>> pairs;
+    for (size_t i = 0; i < queries; i++) {
+        pairs.push_back({ codes[(i * 7919) % n], codes[(i * 104729 + n / 2) % n] });
+    }
+    graph.setResultCacheSize(0);
+    SearchWorkspace ws;
+
+    cout << "\nSEARCH QUEUE BENCHMARK (" << queries << " cheapest + " << queries
+        << " fastest queries, " << n << " airports)\n";
+    cout << string(66, '-') << "\n";
+    cout << left << setw(10) << "QUEUE" << setw(10) << "SEARCH" << setw(12) << "SECONDS"
+        << setw(14) << "QUERIES/S" << setw(12) << "SETTLED" << "SETTLED/S\n";
+
+    for (bool goalDirected : { false, true }) {
+        graph.setGoalDirectedSearch(goalDirected);
+        double expectedTotal = -1;
+        for (QueueKind kind : KINDS) {
+            graph.setSearchQueue(kind);
+            size_t settled = 0;
+            double total = 0; // best cost plus best duration of every query
+            auto started = chrono::steady_clock::now();
+            for (const auto& query : pairs) {
+                vector<Route> cheapest = graph.findCheapestRoute(query.first, query.second, ws);
+                settled += ws.settled;
+                vector<Route> fastest = graph.findFastestRoute(query.first, query.second, ws);
+                settled += ws.settled;
+                if (!cheapest.empty()) total += cheapest[0].totalCost;
+                if (!fastest.empty()) total += fastest[0].totalDuration;
+            }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+            // All queues must find routes of the same totals
+            if (expectedTotal < 0) expectedTotal = total;
+            else if (abs(total - expectedTotal) > 1e-6 * max(1.0, expectedTotal)) {
+                cerr << "Error: " << queueKindName(kind) << " queue found different routes\n";
+                return 1;
+            }
+
+            double rate = seconds > 0 ? 2 * queries / seconds : 0;
+            cout << left << setw(10) << queueKindName(kind) << setw(10) << (goalDirected ? "A*" : "Dijkstra")
+                << setw(12) << fixed << setprecision(3) << seconds
+                << setw(14) << setprecision(0) << rate << setw(12) << settled
+                << (seconds > 0 ? settled / seconds : 0) << "\n";
+        }
+    }
+    cout << string(66, '-') << "\n";
+    return 0;
+}
+
+// Prompt for one line of comma-separated names (airlines may contain spaces)
+vector<string> promptList(const string& prompt) {
+    cout << prompt;
+    string line, item;
+    getline(cin, line);
+
+    vector<string> items;
+    stringstream list(line);
+    while (getline(list, item, ',')) {
+        size_t first = item.find_first_not_of(" \t\r");
+        if (first == string::npos) continue;
+        size_t last = item.find_last_not_of(" \t\r");
+        items.push_back(item.substr(first, last - first + 1));
+    }
+    return items;
+}
+
+int main(int argc, char* argv[]) {
     FlightGraph graph;
 
-    cout << "\n";
-    cout << "--------------------------------------------------\n";
-    cout << "           SMART AIRLINE ROUTE FINDER             \n";
-    cout << "--------------------------------------------------\n\n";
+    string snapshotFile;      // --snapshot <file>: map a binary snapshot instead of parsing JSON
+    string buildSnapshotFile; // --build-snapshot <file>: save the loaded network as a snapshot and exit
+    int loadThreads = 1;      // --load-threads <n>: parse flights.json on n threads (0 = all cores)
+    string batchFile;         // --batch <file>: answer JSONL route requests ("-" = stdin) and exit
+    int queryThreads = 1;     // --query-threads <n>: answer batch requests on n threads (0 = all cores)
+    bool useAStar = true;     // --no-astar: plain Dijkstra for routes (to compare settled counts)
+    bool useHierarchies = false; // --ch: preprocess contraction hierarchies for cheapest/fastest routes
+    bool useBidirectional = false; // --bidirectional: search from both ends instead of A*
+    string landmarkFile;      // --landmarks <file>: load ALT tables from file, building and saving them if stale
+    size_t landmarkCount = DEFAULT_LANDMARK_COUNT; // --landmark-count <n>: landmarks to build
+    string matrixFile;        // --matrix <file>: write the route matrix between all airports and exit
+    vector<string> matrixCities; // --matrix-cities <A,B,...>: restrict the matrix to these airports
+    bool matrixByCost = true; // --matrix-objective cheapest|fastest: routes the matrix describes
+    bool matrixBenchmark = false; // --matrix-benchmark: time matrices of growing size and exit
+    bool memoryReport = false; // --memory-report: print the memory used by the loaded graph and exit
+    long long cacheMegabytes = -1; // --cache-mb <n>: result cache budget (0 = off, default 64)
+    int alternativesBudget = DEFAULT_ALTERNATIVES_BUDGET_MS; // --alternatives-ms <n>: latency budget of k_cheapest/k_fastest
+    QueueKind searchQueue = DEFAULT_QUEUE; // --queue binary|quad|radix: priority queue of the searches
+    size_t queueBenchmarkQueries = 0; // --queue-benchmark <n>: time n queries per objective on every queue and exit
+    bool integerWeights = false; // --integer-weights: store fares in cents and durations in minutes
+    size_t syntheticAirports = 0; // --synthetic <airports> <flights>: generate a network instead of loading JSON
+    size_t syntheticFlights = 0;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--snapshot" && i + 1 < argc) {
+            snapshotFile = argv[++i];
+        }
+        else if (arg == "--build-snapshot" && i + 1 < argc) {
+            buildSnapshotFile = argv[++i];
+        }
+        else if (arg == "--load-threads" && i + 1 < argc) {
+            loadThreads = atoi(argv[++i]);
+        }
+        else if (arg == "--batch" && i + 1 < argc) {
+            batchFile = argv[++i];
+        }
+        else if (arg == "--query-threads" && i + 1 < argc) {
+            queryThreads = atoi(argv[++i]);
+        }
+        else if (arg == "--no-astar") {
+            useAStar = false;
+        }
+        else if (arg == "--bidirectional") {
+            useBidirectional = true;
+        }
+        else if (arg == "--ch") {
+            useHierarchies = true;
+        }
+        else if (arg == "--landmarks" && i + 1 < argc) {
+            landmarkFile = argv[++i];
+        }
+        else if (arg == "--landmark-count" && i + 1 < argc) {
+            landmarkCount = (size_t)max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--matrix" && i + 1 < argc) {
+            matrixFile = argv[++i];
+        }
+        else if (arg == "--matrix-cities" && i + 1 < argc) {
+            stringstream list(argv[++i]);
+            string code;
+            while (getline(list, code, ',')) {
+                transform(code.begin(), code.end(), code.begin(), ::toupper);
+                if (!code.empty()) matrixCities.push_back(code);
+            }
+        }
+        else if (arg == "--matrix-objective" && i + 1 < argc &&
+            (string(argv[i + 1]) == "cheapest" || string(argv[i + 1]) == "fastest")) {
+            matrixByCost = string(argv[++i]) == "cheapest";
+        }
+        else if (arg == "--matrix-benchmark") {
+            matrixBenchmark = true;
+        }
+        else if (arg == "--memory-report") {
+            memoryReport = true;
+        }
+        else if (arg == "--cache-mb" && i + 1 < argc) {
+            cacheMegabytes = max(0LL, atoll(argv[++i]));
+        }
+        else if (arg == "--alternatives-ms" && i + 1 < argc) {
+            alternativesBudget = max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--queue" && i + 1 < argc && parseQueueKind(argv[i + 1], searchQueue)) {
+            i++;
+        }
+        else if (arg == "--queue-benchmark" && i + 1 < argc) {
+            queueBenchmarkQueries = (size_t)max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--integer-weights") {
+            integerWeights = true;
+        }
+        else if (arg == "--synthetic" && i + 2 < argc) {
+            syntheticAirports = (size_t)max(0LL, atoll(argv[++i]));
+            syntheticFlights = (size_t)max(0LL, atoll(argv[++i]));
+        }
+        else {
+            cerr << "Usage: " << argv[0] << " [--snapshot <file> | --synthetic <airports> <flights>]"
+                << " [--build-snapshot <file>]"
+                << " [--load-threads <n>] [--batch <file>|-] [--query-threads <n>] [--no-astar]"
+                << " [--landmarks <file> [--landmark-count <n>]] [--ch] [--bidirectional]"
+                << " [--matrix <file> [--matrix-cities <A,B,...>] | --matrix-benchmark]"
+                << " [--matrix-objective cheapest|fastest] [--cache-mb <n>] [--alternatives-ms <n>]"
+                << " [--queue binary|quad|radix | --queue-benchmark <n>] [--integer-weights] [--memory-report]\n";
+            return 1;
+        }
+    }
+
+    if (loadThreads <= 0) {
+        loadThreads = max(1, (int)thread::hardware_concurrency());
+    }
+    if (queryThreads <= 0) {
+        queryThreads = max(1, (int)thread::hardware_concurrency());
+    }
+
+    // In batch mode stdout carries only results, so load messages go to stderr
+    if (!batchFile.empty()) {
+        ios::sync_with_stdio(false);
+    }
+    streambuf* consoleOut = cout.rdbuf();
+    if (!batchFile.empty()) {
+        cout.rdbuf(cerr.rdbuf());
+    }
+    else {
+        cout << "\n";
+        cout << "--------------------------------------------------\n";
+        cout << "           SMART AIRLINE ROUTE FINDER             \n";
+        cout << "--------------------------------------------------\n\n";
+    }
+
+    graph.setIntegerWeights(integerWeights);
+    if (!snapshotFile.empty()) {
+        // Map the compiled snapshot instead of parsing JSON
+        if (!graph.loadSnapshot(snapshotFile)) {
+            cerr << "\nFailed to load snapshot!\n";
+            cerr << "Rebuild it with --build-snapshot " << snapshotFile << "\n\n";
+            return 1;
+        }
+    }
+    else if (syntheticAirports > 0) {
+        if (!graph.generateSyntheticNetwork(syntheticAirports, syntheticFlights)) {
+            cerr << "\nFailed to generate the synthetic network!\n\n";
+            return 1;
+        }
+    }
+    else {
+        // Load cities from separate file
+        if (!graph.loadCitiesFromJSON("cities.json")) {
+            cerr << "\nFailed to load cities data!\n";
+            cerr << "Please ensure 'cities.json' exists.\n\n";
+            return 1;
+        }
+
+        // Load flights from separate file
+        if (!graph.loadFlightsFromJSON("flights.json", loadThreads)) {
+            cerr << "\nFailed to load flights data!\n";
+            cerr << "Please ensure 'flights.json' exists.\n\n";
+            return 1;
+        }
+    }
+
+    if (!buildSnapshotFile.empty()) {
+        return graph.saveSnapshot(buildSnapshotFile) ? 0 : 1;
+    }
 
-    // Load cities from separate file
-    if (!graph.loadCitiesFromJSON("cities.json")) {
-        cerr << "\nFailed to load cities data!\n";
-        cerr << "Please ensure 'cities.json' exists.\n\n";
-        return 1;
+    graph.setSearchQueue(searchQueue);
+    if (queueBenchmarkQueries > 0) {
+        return runQueueBenchmark(graph, queueBenchmarkQueries);
+    }
+
+    // Matrices use one-to-all searches, so the query accelerations below do not apply
+    if (matrixBenchmark) {
+        return runMatrixBenchmark(graph, matrixByCost, queryThreads);
+    }
+    if (!matrixFile.empty()) {
+        return runRouteMatrix(graph, matrixFile, matrixCities, matrixByCost, queryThreads);
+    }
+
+    graph.setGoalDirectedSearch(useAStar);
+    graph.setBidirectionalSearch(useBidirectional);
+    if (cacheMegabytes >= 0) {
+        graph.setResultCacheSize((size_t)cacheMegabytes << 20);
+    }
+    graph.setAlternativesBudget(alternativesBudget);
+    if (useAStar && !landmarkFile.empty()) {
+        graph.prepareLandmarks(landmarkFile, landmarkCount);
+    }
+    if (useHierarchies) {
+        graph.buildHierarchies();
+    }
+    if (memoryReport) {
+        graph.displayMemoryReport();
+        return 0;
     }
 
-    // Load flights from separate file
-    if (!graph.loadFlightsFromJSON("flights.json")) {
-        cerr << "\nFailed to load flights data!\n";
-        cerr << "Please ensure 'flights.json' exists.\n\n";
-        return 1;
+    if (!batchFile.empty()) {
+        cout.rdbuf(consoleOut);
+        if (batchFile == "-") {
+            return runBatchQueries(graph, cin, cout, queryThreads);
+        }
+
+        ifstream requests(batchFile, ios::binary);
+        if (!requests.is_open()) {
+            cerr << "Error: Could not open " << batchFile << endl;
+            return 1;
+        }
+        return runBatchQueries(graph, requests, cout, queryThreads);
     }
 
     graph.displayStats();
@@ -1120,7 +6731,7 @@ int main() {
             break;
         }
 
-        if (choice >= 1 && choice <= 5) {
+        if ((choice >= 1 && choice <= 5) || (choice >= 10 && choice <= 13)) {
             cout << "\nEnter source city code (e.g., KHI, ISB, LHE): ";
             cin >> source;
             cout << "Enter destination city code (e.g., LHR, DXB, JFK): ";
@@ -1211,11 +6822,66 @@ int main() {
             graph.displayGraph();
             break;
         }
+        case 10: {
+            vector<Route> paretoRoutes = graph.findParetoRoutes(source, dest,
+                CRITERION_COST | CRITERION_DURATION | CRITERION_HOPS);
+            graph.displayParetoRoutes(paretoRoutes, "Cost, Duration and Stops");
+            break;
+        }
+        case 11: {
+            string day, clock;
+            cout << "Enter local departure day and time (e.g., Mon 08:00): ";
+            cin >> day >> clock;
+
+            int departAt = parseWeekMinute(day + " " + clock);
+            if (departAt < 0) {
+                cout << "\nInvalid departure time!\n";
+                break;
+            }
+            graph.freeze();
+            departAt = graph.localToUtc(source, departAt);
+            Itinerary itinerary = graph.findEarliestArrival(source, dest, departAt);
+            graph.displayItinerary(itinerary, departAt);
+            break;
+        }
+        case 12: {
+            RouteFilter filter;
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            filter.airlines = promptList("Fly only these airlines (comma-separated, Enter for any): ");
+            filter.excludedAirlines = promptList("Avoid these airlines (Enter for none): ");
+            filter.excludedTransits = promptList("Avoid connecting through these airports (Enter for none): ");
+            cout << "Enter number of passengers: ";
+            if (!(cin >> filter.passengers) || filter.passengers < 1) {
+                cin.clear();
+                cout << "\nInvalid number of passengers!\n";
+                break;
+            }
+
+            cout << "Using only flights with at least " << filter.passengers << " seats available.\n";
+            graph.displayMultipleRoutes(graph.findCheapestRoute(source, dest, filter), "CHEAPEST");
+            graph.displayMultipleRoutes(graph.findFastestRoute(source, dest, filter), "FASTEST");
+            graph.displayRoute(graph.findMinimumStops(source, dest, filter), "MINIMUM STOPS ROUTE (BFS)");
+            graph.displayParetoRoutes(graph.findParetoOptimalRoutes(source, dest, filter));
+            break;
+        }
+        case 13: {
+            int rank;
+            cout << "Rank by (1) cost or (2) duration: ";
+            if (!(cin >> rank) || (rank != 1 && rank != 2)) {
+                cin.clear();
+                cout << "\nInvalid choice!\n";
+                break;
+            }
+            bool byCost = rank == 1;
+            graph.displayAlternativeRoutes(graph.findAlternativeRoutes(source, dest, byCost),
+                byCost ? "CHEAPEST" : "FASTEST");
+            break;
+        }
         default:
             cout << "\nInvalid choice! Please try again.\n";
         }
 
-        if (choice >= 1 && choice <= 9) {
+        if (choice >= 1 && choice <= 13) {
             cout << "Press Enter to continue...";
             // Clear cin buffer
             cin.ignore(numeric_limits<streamsize>::max(), '\n');